@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 #QT       += multimedia
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
@@ -10,27 +10,92 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    fbDevice.cpp \
+    frameScheduler.cpp \
+    gpioInput.cpp \
     gpioKeys.cpp \
     main.cpp \
     dinosaur.cpp \
     mainWindow.cpp \
-    scoreManager.cpp
+    rgb565.cpp \
+    scoreHud.cpp \
+    scoreManager.cpp \
+    skinCache.cpp \
+    spriteAtlas.cpp \
+    spriteBatch565.cpp \
+    spriteBlob.cpp
 
 HEADERS += \
     dinosaur.h \
+    fbDevice.h \
+    frameScheduler.h \
+    gpioInput.h \
     gpioKeys.h \
     mainWindow.h \
-    scoreManager.h
+    rgb565.h \
+    scoreHud.h \
+    scoreManager.h \
+    skinCache.h \
+    spriteAtlas.h \
+    spriteBatch565.h \
+    spriteBlob.h
 
 FORMS += \
     dinosaur.ui
 
 RESOURCES += resources.qrc 
 
+include(gameCore/gameCore.pri)
+
+# GPIO buttons: the character device through libgpiod v2 when available,
+# sysfs otherwise (see gpioInput.h)
+LIBS += -lpthread
+packagesExist(libgpiod >= 2.0) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libgpiod
+    DEFINES += HAVE_LIBGPIOD
+} else {
+    message("libgpiod v2 not found, GPIO buttons use sysfs only")
+}
+
+# Sprite bake: tools/spriteBake pre-scales every sprite into sprites.bin,
+# which the game maps at startup instead of decoding the PNGs. The tool has
+# to run on the build host, so when cross-compiling build it with the host
+# Qt and pass its path: qmake SPRITE_BAKE=/path/to/spriteBake
+isEmpty(SPRITE_BAKE):!cross_compile {
+    SPRITE_BAKE = $$OUT_PWD/spriteBake/spriteBake
+    spritebake.target = $$SPRITE_BAKE
+    spritebake.commands = $(MKDIR) $$OUT_PWD/spriteBake && \
+        cd $$OUT_PWD/spriteBake && \
+        $$QMAKE_QMAKE $$PWD/tools/spriteBake/spriteBake.pro && $(MAKE)
+    spritebake.depends = $$PWD/tools/spriteBake/main.cpp \
+        $$PWD/spriteBlob.cpp $$PWD/spriteBlob.h
+    QMAKE_EXTRA_TARGETS += spritebake
+}
+
+!isEmpty(SPRITE_BAKE) {
+    spriteblob.target = $$OUT_PWD/sprites.bin
+    spriteblob.commands = $$SPRITE_BAKE $$PWD/images $$OUT_PWD/sprites.bin
+    spriteblob.depends = $$SPRITE_BAKE
+    QMAKE_EXTRA_TARGETS += spriteblob
+    PRE_TARGETDEPS += $$OUT_PWD/sprites.bin
+    QMAKE_CLEAN += $$OUT_PWD/sprites.bin
+
+    sprites.files = $$OUT_PWD/sprites.bin
+    sprites.CONFIG += no_check_exist
+} else {
+    message("SPRITE_BAKE not set, sprites are decoded at runtime")
+}
+
 # Default rules for deployment.
 #qnx: target.path = /tmp/$${TARGET}/bin
 #else: unix:!android: target.path = /opt/$${TARGET}/bin
 #!isEmpty(target.path): INSTALLS += target
 
 target.path = $$PWD/Game
-INSTALLS += target
\ No newline at end of file
+INSTALLS += target
+
+!isEmpty(SPRITE_BAKE) {
+    sprites.path = $$target.path
+    INSTALLS += sprites
+}
\ No newline at end of file
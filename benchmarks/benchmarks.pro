@@ -0,0 +1,43 @@
+# Micro-benchmarks for the game loop stages (Google Benchmark).
+# Run with --benchmark_out=<file> --benchmark_out_format=json to keep results
+QT       += core gui widgets concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = dinoBench
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    ../dinosaur.cpp \
+    ../fbDevice.cpp \
+    ../frameScheduler.cpp \
+    ../gpioInput.cpp \
+    ../gpioKeys.cpp \
+    ../rgb565.cpp \
+    ../scoreHud.cpp \
+    ../skinCache.cpp \
+    ../spriteAtlas.cpp \
+    ../spriteBatch565.cpp \
+    ../spriteBlob.cpp
+
+HEADERS += \
+    ../dinosaur.h \
+    ../fbDevice.h \
+    ../frameScheduler.h \
+    ../gpioInput.h \
+    ../gpioKeys.h \
+    ../rgb565.h \
+    ../scoreHud.h \
+    ../skinCache.h \
+    ../spriteAtlas.h \
+    ../spriteBatch565.h \
+    ../spriteBlob.h
+
+RESOURCES += ../resources.qrc
+
+include(../gameCore/gameCore.pri)
+
+LIBS += -lbenchmark -lpthread
@@ -0,0 +1,246 @@
+// Benchmarks for the stages of a game frame: physics, collision, spawning
+// and painting, swept over the number of obstacles on screen and day/night.
+//
+// usage: dinoBench [--benchmark_out=results.json --benchmark_out_format=json]
+#include "dinosaur.h"
+#include "gameState.h"
+#include "rgb565.h"
+#include <QApplication>
+#include <QImage>
+#include <QSysInfo>
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const float STEP = 1.f / 120.f;
+
+// A running game with `count` cacti, birds and clouds spread over the
+// screen, none touching the dino. Spawning is pushed far into the future so
+// the obstacle count stays fixed. Collision masks are taken from `base`.
+GameState makeScene(int count, bool night,
+                    const GameState &base = GameState()) {
+  GameState g = base;
+  g.reset();
+  g.started = true;
+  g.currentState = GameState::RUN;
+
+  const GameConfig &cfg = g.config();
+  for (int i = 0; i < count; ++i) {
+    float x = 120.f + (cfg.width - 120.f) * i / std::max(1, count);
+    int type = i % 6;
+    g.cactus.spawn(GameRect{x, float(cfg.groundY - cfg.cactusH[type]),
+                            float(cfg.cactusW[type]), float(cfg.cactusH[type])},
+                   type);
+    g.birds.spawn(GameRect{x + 20.f, float(cfg.groundY - 120),
+                           float(cfg.birdW), float(cfg.birdH)});
+    g.clouds.spawn(GameRect{x, 40.f, float(cfg.cloudW), float(cfg.cloudH)});
+  }
+  g.spawnTimer = 1e9f;
+  g.isNight = night;
+  return g;
+}
+
+void obstacleArgs(benchmark::internal::Benchmark *b) {
+  for (int count : {0, 1, 4, 16, 64})
+    b->Arg(count);
+}
+
+void obstacleNightArgs(benchmark::internal::Benchmark *b) {
+  for (int night : {0, 1}) {
+    for (int count : {0, 1, 4, 16, 64})
+      b->Args({count, night});
+  }
+}
+
+void BM_UpdatePhysics(benchmark::State &state) {
+  const GameState scene = makeScene(state.range(0), false);
+  GameState g = scene;
+  int n = 0;
+  for (auto _ : state) {
+    unsigned events = 0;
+    g.updatePhysics(STEP, events);
+    benchmark::DoNotOptimize(events);
+    // obstacles drift off screen, move them back now and then. Pausing the
+    // timer for this would cost more than the steps themselves.
+    if (++n == 64) {
+      float back = g.distanceTraveled - scene.distanceTraveled;
+      g.cactus.moveBy(back);
+      g.birds.moveBy(back * g.config().birdSpeedFactor);
+      g.clouds.moveBy(back * g.config().cloudSpeedFactor);
+      g.distanceTraveled = scene.distanceTraveled;
+      g.score = scene.score;
+      n = 0;
+    }
+  }
+  state.counters["obstacles"] = 3 * state.range(0);
+}
+BENCHMARK(BM_UpdatePhysics)->Apply(obstacleArgs);
+
+void BM_CheckCollision(benchmark::State &state) {
+  const GameState g = makeScene(state.range(0), false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(g.checkCollision());
+  }
+  state.counters["obstacles"] = 3 * state.range(0);
+}
+BENCHMARK(BM_CheckCollision)->Apply(obstacleArgs);
+
+// Moves the first cactus as far into the dino's box as it goes without their
+// pixels touching, so checkCollision() reaches the pixel test for it and
+// then goes on to the other obstacles
+void placeNearMiss(GameState &g) {
+  if (g.cactus.empty())
+    return;
+  const GameState::Obstacles cacti = g.cactus;
+  auto place = [&](float x) {
+    GameRect first = cacti[0];
+    first.x = x;
+    g.cactus.clear();
+    g.cactus.spawn(first, cacti.type(0));
+    for (int i = 1; i < cacti.size(); ++i)
+      g.cactus.spawn(cacti[i], cacti.type(i));
+  };
+
+  float x = g.dino.right();
+  for (float depth = 1.f; depth < g.dino.w; depth += 1.f) {
+    place(g.dino.right() - depth);
+    if (g.checkCollision())
+      break;
+    x = g.dino.right() - depth;
+  }
+  place(x);
+}
+
+// Same scene with the pixel masks of the real sprites and the first cactus a
+// near miss
+void BM_CheckCollisionMasks(benchmark::State &state) {
+  dinosaur w;
+  w.setSkin(0);
+  GameState g = makeScene(state.range(0), false, w.state());
+  placeNearMiss(g);
+  if (g.checkCollision()) {
+    state.SkipWithError("the scene hits the dino");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(g.checkCollision());
+  }
+  state.counters["obstacles"] = 3 * state.range(0);
+}
+BENCHMARK(BM_CheckCollisionMasks)->Apply(obstacleArgs);
+
+template <void (GameState::*Spawn)()>
+void BM_Spawn(benchmark::State &state) {
+  GameState g = makeScene(0, false);
+  int n = 0;
+  for (auto _ : state) {
+    (g.*Spawn)();
+    // clearing is cheaper than pausing the timer for it
+    if (++n == 256) {
+      g.cactus.clear();
+      g.birds.clear();
+      g.clouds.clear();
+      n = 0;
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BM_Spawn, &GameState::spawnCactus)->Name("BM_SpawnCactus");
+BENCHMARK_TEMPLATE(BM_Spawn, &GameState::spawnBird)->Name("BM_SpawnBird");
+BENCHMARK_TEMPLATE(BM_Spawn, &GameState::spawnCloud)->Name("BM_SpawnCloud");
+
+void BM_PaintEvent(benchmark::State &state) {
+  dinosaur w;
+  w.setSkin(0);
+  w.state() = makeScene(state.range(0), state.range(1) != 0, w.state());
+
+  QImage target(w.size(), QImage::Format_ARGB32_Premultiplied);
+  for (auto _ : state) {
+    w.render(&target);
+    benchmark::ClobberMemory();
+  }
+  state.counters["obstacles"] = 3 * state.range(0);
+  state.counters["night"] = state.range(1);
+}
+BENCHMARK(BM_PaintEvent)->Apply(obstacleNightArgs);
+
+// The sprites of a frame drawn with one drawPixmap each as before batching
+// (batched 0), or from the atlases through SpriteBatch (batched 1)
+void BM_DrawSprites(benchmark::State &state) {
+  dinosaur w;
+  w.setSkin(0);
+  w.state() = makeScene(state.range(0), state.range(1) != 0, w.state());
+  const bool batched = state.range(2) != 0;
+
+  QImage target(w.size(), QImage::Format_ARGB32_Premultiplied);
+  dinosaur::DrawStats stats{};
+  for (auto _ : state) {
+    stats = w.renderSprites(target, batched);
+    benchmark::ClobberMemory();
+  }
+  state.counters["obstacles"] = 3 * state.range(0);
+  state.counters["night"] = state.range(1);
+  state.counters["batched"] = state.range(2);
+  state.counters["sprites"] = stats.sprites;
+  state.counters["draw_calls"] = stats.drawCalls;
+}
+BENCHMARK(BM_DrawSprites)->Apply([](benchmark::internal::Benchmark *b) {
+  for (int batched : {0, 1}) {
+    for (int night : {0, 1}) {
+      for (int count : {0, 4, 64})
+        b->Args({count, night, batched});
+    }
+  }
+});
+
+// A whole frame for a 16 bpp framebuffer: painted by Qt in ARGB32 and
+// converted (format 0), or composited in RGB565 directly (format 1)
+void BM_ComposeFrame(benchmark::State &state) {
+  dinosaur w;
+  w.setSkin(0);
+  w.state() = makeScene(state.range(0), state.range(1) != 0, w.state());
+  const bool rgb565 = state.range(2) != 0;
+
+  QImage argb(w.size(), QImage::Format_ARGB32_Premultiplied);
+  QImage frame(w.size(), QImage::Format_RGB16);
+  for (auto _ : state) {
+    if (rgb565) {
+      w.renderRgb565(frame);
+    } else {
+      w.render(&argb);
+      frame = argb.convertToFormat(QImage::Format_RGB16);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.counters["obstacles"] = 3 * state.range(0);
+  state.counters["night"] = state.range(1);
+  state.counters["rgb565"] = state.range(2);
+}
+BENCHMARK(BM_ComposeFrame)->Apply([](benchmark::internal::Benchmark *b) {
+  for (int format : {0, 1}) {
+    for (int night : {0, 1}) {
+      for (int count : {0, 4, 64})
+        b->Args({count, night, format});
+    }
+  }
+});
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  // painting needs a QApplication but no display
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication app(argc, argv);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  // to tell ARM and x86 result files apart
+  benchmark::AddCustomContext("cpu_arch",
+                              QSysInfo::currentCpuArchitecture().toStdString());
+  benchmark::AddCustomContext("qt_version", qVersion());
+  benchmark::AddCustomContext("blit565_isa", blit565Isa());
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -1,23 +1,44 @@
 #include "dinosaur.h"
+#include "gpioInput.h"
 #include "gpioKeys.h"
-#include <QApplication>
+#include "spriteBatch565.h"
+#include "spriteBlob.h"
+#include "trace.h"
 #include <QDebug>
 #include <QKeyEvent>
+#include <QPaintEvent>
 #include <QPainter>
-#include <QRandomGenerator>
+#include <QTimer>
+#include <QtMath>
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
-
-void loadFrames(QVector<QPixmap> &vec, const QString &baseName, int count,
-                const QSize &targetSize) {
-  for (int i = 0; i < count; ++i) {
-    QString path =
-        QString(":/images/images/%1_%2.png").arg(baseName).arg(i + 1);
-    QPixmap pm(path);
-    if (!pm.isNull()) {
-      vec.push_back(
-          pm.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Night palette: grayscale lightened by 100, alpha preserved. Works on whole
+// scanlines without branches so the compiler can vectorize the loop.
+QPixmap toNightPixmap(const QPixmap &src) {
+  QImage img = src.toImage().convertToFormat(QImage::Format_ARGB32);
+  for (int y = 0; y < img.height(); ++y) {
+    QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+    for (int x = 0; x < img.width(); ++x) {
+      quint32 px = line[x];
+      quint32 a = px >> 24;
+      quint32 r = (px >> 16) & 0xff;
+      quint32 g = (px >> 8) & 0xff;
+      quint32 b = px & 0xff;
+      // same weights as qGray()
+      quint32 gray = (r * 11 + g * 16 + b * 5) / 32 + 100;
+      gray = gray > 255 ? 255 : gray;
+      quint32 tinted = (a << 24) | (gray << 16) | (gray << 8) | gray;
+      // fully transparent pixels are left untouched
+      line[x] = a ? tinted : px;
     }
   }
+  return QPixmap::fromImage(img);
 }
 
 dinosaur::dinosaur(QWidget *parent) : QWidget(parent) {
@@ -28,46 +49,30 @@ dinosaur::dinosaur(QWidget *parent) : QWidget(parent) {
 
   GpioKeys *gpio = new GpioKeys(this);
 
-  connect(gpio, &GpioKeys::keyUpPressed, this, [this]() {
-    QKeyEvent event(QEvent::KeyPress, Qt::Key_Up, Qt::NoModifier);
-    QApplication::sendEvent(this, &event);
-  });
-
-  connect(gpio, &GpioKeys::keyUpReleased, this, [this]() {
-    QKeyEvent event(QEvent::KeyRelease, Qt::Key_Up, Qt::NoModifier);
-    QApplication::sendEvent(this, &event);
-  });
-
-  connect(gpio, &GpioKeys::keyDownPressed, this, [this]() {
-    QKeyEvent event(QEvent::KeyPress, Qt::Key_Down, Qt::NoModifier);
-    QApplication::sendEvent(this, &event);
-  });
-
-  connect(gpio, &GpioKeys::keyDownReleased, this, [this]() {
-    QKeyEvent event(QEvent::KeyRelease, Qt::Key_Down, Qt::NoModifier);
-    QApplication::sendEvent(this, &event);
-  });
-
-  cloudSprite.load(":/images/images/Cloud.png");
-  groundSprite.load(":/images/images/Ground.png");
-  gameOverImage.load(":/images/images/Game_Over.png");
-  cloudSprite =
-      cloudSprite.scaled(60, 60, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  groundSprite = groundSprite.scaledToHeight(20, Qt::SmoothTransformation);
-  gameOverImage = gameOverImage.scaled(200, 60, Qt::KeepAspectRatio,
-                                       Qt::SmoothTransformation);
+  // buttons go straight to the simulation with their edge times
+  connect(gpio, &GpioKeys::keyUpPressed, this,
+          [this](qint64 t) { press(InputLatch::JUMP, true, t); });
+  connect(gpio, &GpioKeys::keyUpReleased, this,
+          [this](qint64 t) { press(InputLatch::JUMP, false, t); });
+  connect(gpio, &GpioKeys::keyDownPressed, this,
+          [this](qint64 t) { press(InputLatch::DUCK, true, t); });
+  connect(gpio, &GpioKeys::keyDownReleased, this,
+          [this](qint64 t) { press(InputLatch::DUCK, false, t); });
+
+  cloudSprite = QPixmap::fromImage(loadSprite("Cloud", QSize(60, 60)));
+  groundSprite = QPixmap::fromImage(loadSprite("Ground", QSize(0, 20)));
+  gameOverImage =
+      QPixmap::fromImage(loadSprite("Game_Over", QSize(200, 60)));
 
   // Control buttons
   btnReturn = new QPushButton(this);
   btnRestart = new QPushButton(this);
 
-  QPixmap returnImg(":/images/images/Back_Button.png");
   QPixmap scaledReturn =
-      returnImg.scaled(48, 48, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+      QPixmap::fromImage(loadSprite("Back_Button", QSize(48, 48)));
 
-  QPixmap restartImg(":/images/images/Restart.png");
   QPixmap scaledRestart =
-      restartImg.scaled(48, 48, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+      QPixmap::fromImage(loadSprite("Restart", QSize(48, 48)));
 
   btnReturn->setIcon(scaledReturn);
   btnReturn->setIconSize(QSize(48, 48));
@@ -96,23 +101,55 @@ dinosaur::dinosaur(QWidget *parent) : QWidget(parent) {
   btnRestart->setStyleSheet("border: none; background: transparent;");
 
   // Bird sprites
-  birdSprite1.load(":/images/images/Bird1.png");
-  birdSprite2.load(":/images/images/Bird2.png");
-  birdSprite1 =
-      birdSprite1.scaled(42, 27, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  birdSprite2 =
-      birdSprite2.scaled(42, 27, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  birdSprite1 = QPixmap::fromImage(loadSprite("Bird1", QSize(42, 27)));
+  birdSprite2 = QPixmap::fromImage(loadSprite("Bird2", QSize(42, 27)));
 
   // Cactus sprites
   for (int i = 1; i <= 3; ++i) {
-    QPixmap largeCactus(QString(":/images/images/LargeCactus%1.png").arg(i));
-    largeCactusSprites.push_back(largeCactus.scaled(60, 35, Qt::KeepAspectRatio,
-                                                    Qt::SmoothTransformation));
+    largeCactusSprites.push_back(QPixmap::fromImage(
+        loadSprite(QString("LargeCactus%1").arg(i), QSize(60, 35))));
+    smallCactusSprites.push_back(QPixmap::fromImage(
+        loadSprite(QString("SmallCactus%1").arg(i), QSize(60, 25))));
+  }
 
-    QPixmap smallCactus(QString(":/images/images/SmallCactus%1.png").arg(i));
-    smallCactusSprites.push_back(smallCactus.scaled(60, 25, Qt::KeepAspectRatio,
-                                                    Qt::SmoothTransformation));
+  buildNightSprites();
+  buildGroundStrips();
+  buildAtlas();
+
+  // collision boxes and spawn sizes follow the loaded sprites
+  GameConfig config;
+  config.width = width();
+  for (int i = 0; i < 3; ++i) {
+    config.cactusW[i] = largeCactusSprites[i].width();
+    config.cactusH[i] = largeCactusSprites[i].height();
+    config.cactusW[i + 3] = smallCactusSprites[i].width();
+    config.cactusH[i + 3] = smallCactusSprites[i].height();
   }
+  config.cloudW = cloudSprite.width();
+  config.cloudH = cloudSprite.height();
+  if (!groundSprite.isNull())
+    config.groundTileW = groundSprite.width();
+  game = GameState(config);
+
+  // pixel masks for collisions, placed where the sprites are drawn
+  auto obstacleMasks = std::make_shared<ObstacleMasks>();
+  for (int i = 0; i < 3; ++i) {
+    obstacleMasks->cactus[i] = spriteMask(largeCactusSprites[i].toImage());
+    obstacleMasks->cactus[i + 3] = spriteMask(smallCactusSprites[i].toImage());
+  }
+  obstacleMasks->bird[0] = spriteMask(birdSprite1.toImage());
+  obstacleMasks->bird[1] = spriteMask(birdSprite2.toImage());
+  // wings up is drawn 7px higher, see paintEvent
+  obstacleMasks->bird[1].setOffset(0, -7);
+  game.setObstacleMasks(obstacleMasks);
+
+  // decode every skin in the background so starting a game does not stall
+  skinCache.preloadAll();
+
+  // score digits, dark gray by day; the score area is wide enough for
+  // "HI 00000 00000"
+  hud.build(QFont("Menlo", 15, QFont::Bold), QColor(83, 83, 83), Qt::white);
+  hudRect = hud.bounds(width() - 20, 30).adjusted(-2, -2, 2, 2);
 
 #ifdef SOUND
   sJump.setSource(QUrl("qrc:/sounds/sounds/jump.wav"));
@@ -123,93 +160,237 @@ dinosaur::dinosaur(QWidget *parent) : QWidget(parent) {
   sPoint.setVolume(0.20f);
 #endif
 
+  // DINO_FB: draw the game straight into a framebuffer, see FbDevice
+  QByteArray fbSpec = qgetenv("DINO_FB");
+  if (!fbSpec.isEmpty()) {
+    fb.reset(new FbDevice);
+    if (fb->open(fbSpec.toStdString())) {
+      qDebug() << "Framebuffer" << fb->width() << "x" << fb->height()
+               << fb->bitsPerPixel() << "bpp,"
+               << (fb->isPanning() ? "panning" : "copying");
+    } else {
+      qDebug() << "No framebuffer:" << QString::fromStdString(fb->error());
+      fb.reset();
+    }
+  }
+
   reset();
 
-  frame.setTimerType(Qt::PreciseTimer);
-  connect(&frame, &QTimer::timeout, this, &dinosaur::tick);
-  frame.start(16); // ~60 FPS
-  clock.start();
+  // frames on absolute deadlines at the refresh rate; late frames drop the
+  // deadlines they missed and the next one stays on the grid
+  bool hzOk = false;
+  double hz = qEnvironmentVariable("DINO_REFRESH_HZ").toDouble(&hzOk);
+  if (hzOk && hz > 0)
+    frameClock.setRefreshRate(hz);
+  frameClock.setSkipPolicy(FrameScheduler::SKIP_MISSED);
+  if (frameClock.start()) {
+    frameNotifier = new QSocketNotifier(frameClock.fd(),
+                                        QSocketNotifier::Read, this);
+    connect(frameNotifier, &QSocketNotifier::activated, this, [this]() {
+      frameClock.frame();
+      tick();
+    });
+  } else {
+    qWarning() << "No frame timer:" << strerror(errno);
+  }
+
+  simWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  simAckFd = eventfd(0, EFD_CLOEXEC);
+}
+
+dinosaur::~dinosaur() {
+  stopSim();
+  if (simThread.joinable()) {
+    sendSim(SIM_QUIT);
+    simThread.join();
+  }
+  for (int fd : {simWakeFd, simAckFd})
+    if (fd >= 0)
+      close(fd);
+}
+
+dinosaur::SimPause::SimPause(dinosaur *d) : d(d) {
+  if (d->simPauses++ == 0)
+    d->stopSim();
+}
+
+dinosaur::SimPause::~SimPause() {
+  if (--d->simPauses == 0 && d->isVisible())
+    d->startSim();
+}
+
+// The simulation runs while the widget is shown and nothing paused it
+void dinosaur::startSim() {
+  if (simRunning || simPauses || simWakeFd < 0 || simAckFd < 0)
+    return;
+  // a fresh snapshot, taken at once, so frames never show the state from
+  // before a reset
+  publish(monotonicNs());
+  snapshots.update();
+  simRunning = true;
+  if (!simThread.joinable())
+    simThread = std::thread(&dinosaur::simulate, this);
+  sendSim(SIM_RUN);
+}
+
+// Returns once the simulation thread is parked; the game is the GUI
+// thread's until startSim()
+void dinosaur::stopSim() {
+  if (!simRunning)
+    return;
+  sendSim(SIM_PAUSE);
+  uint64_t count;
+  while (::read(simAckFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+  }
+  // pairs with the release in simulate(), after its last step
+  simCommand.load(std::memory_order_acquire);
+  simRunning = false;
+}
+
+void dinosaur::sendSim(int command) {
+  simCommand.store(command, std::memory_order_release);
+  // an eventfd write only fails on counter overflow
+  uint64_t one = 1;
+  while (::write(simWakeFd, &one, sizeof(one)) < 0 && errno == EINTR) {
+  }
+}
+
+// Simulation thread: runs the steps ending at each deadline of a 120 Hz grid
+// while not paused
+void dinosaur::simulate() {
+  FrameScheduler clock(1e9 / simStepNs);
+  for (;;) {
+    // a stopped clock has fd -1, which poll() skips
+    pollfd fds[2] = {{simWakeFd, POLLIN, 0}, {clock.fd(), POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      qWarning() << "Simulation stopped:" << strerror(errno);
+      break;
+    }
+
+    if (fds[0].revents) {
+      uint64_t count;
+      while (::read(simWakeFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+      }
+      int command = simCommand.load(std::memory_order_acquire);
+      if (command == SIM_QUIT)
+        break;
+      if (command == SIM_PAUSE) {
+        clock.stop();
+        simCommand.store(SIM_PAUSED, std::memory_order_release);
+        uint64_t one = 1;
+        while (::write(simAckFd, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+      } else if (command == SIM_RUN && clock.fd() < 0 && !clock.start()) {
+        qWarning() << "No simulation timer:" << strerror(errno);
+      }
+      continue;
+    }
+    if (!fds[1].revents)
+      continue;
+
+    TRACE_SCOPE("simulate");
+    FrameScheduler::Frame f = clock.frame();
+
+    KeyEvent key;
+    while (keyEvents.pop(key)) {
+      if (key.down)
+        input.press(key.button, key.timeNs);
+      else
+        input.release(key.button, key.timeNs);
+    }
+
+    // one step per deadline passed, the last one ending at the newest
+    int due = f.skipped + 1;
+    int steps = std::min(due, maxCatchUpSteps);
+    int64_t end = f.deadlineNs + int64_t(f.skipped) * simStepNs;
+    int64_t startNs = end - int64_t(steps) * simStepNs;
+    for (int i = 0; i < steps && !game.gameOver; ++i) {
+      step(simStep, startNs);
+      startNs += simStepNs;
+    }
+    publish(startNs);
+  }
+}
+
+// The game as it is at timeNs, by the thread stepping it
+void dinosaur::takeSnapshot(RenderSnapshot &s, int64_t timeNs) const {
+  s.capture(game);
+  s.timeNs = timeNs;
+  s.jumps = simJumps;
+  s.points = simPoints;
+  s.jumpPressNs = simJumpPressNs;
+  s.jumpStepNs = simJumpStepNs;
+}
+
+void dinosaur::publish(int64_t timeNs) {
+  takeSnapshot(snapshots.back(), timeNs);
+  snapshots.publish();
+}
+
+// State for the frame being drawn: the snapshot taken by the last tick(),
+// or the game itself when the simulation thread is stopped
+const RenderSnapshot &dinosaur::snapshot() {
+  if (simRunning)
+    return snapshots.front();
+  takeSnapshot(localSnapshot, monotonicNs());
+  return localSnapshot;
+}
+
+void dinosaur::press(InputLatch::Button button, bool down, int64_t timeNs) {
+  if (!keyEvents.push(KeyEvent{button, down, timeNs}))
+    qDebug() << "Key event dropped";
 }
 
 void dinosaur::setSkin(int skin) {
+#ifdef LOAD_STATS
+  firstFrameTimer.start();
+  awaitingFirstFrame = true;
+#endif
+  SimPause pause(this);
   currentSkinIndex = skin;
-  runFrames.clear();
-  duckFrames.clear();
-  if (skin == 0) {
-    // Normal
-    dinoStartSprite.load(":/images/images/Dino_Start.png");
-    dinoJumpSprite.load(":/images/images/Dino_Jump.png");
-    dinoDeadSprite.load(":/images/images/Dino_Dead.png");
-    dinoStartSprite = dinoStartSprite.scaled(36, 40, Qt::KeepAspectRatio,
-                                             Qt::SmoothTransformation);
-    dinoJumpSprite = dinoJumpSprite.scaled(36, 40, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-    dinoDeadSprite = dinoDeadSprite.scaled(36, 40, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-
-    loadFrames(runFrames, "Dino_Run", 2, QSize(36, 40));
-    loadFrames(duckFrames, "Dino_Duck", 2, QSize(72, 25));
-
-  } else if (skin == 1) {
-    // Hat
-    dinoStartSprite.load(":/images/images/Hat_Start.png");
-    dinoJumpSprite.load(":/images/images/Hat_Jump.png");
-    dinoDeadSprite.load(":/images/images/Hat_Dead.png");
-    dinoStartSprite = dinoStartSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                             Qt::SmoothTransformation);
-    dinoJumpSprite = dinoJumpSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-    dinoDeadSprite = dinoDeadSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-
-    loadFrames(runFrames, "Hat_Run", 2, QSize(38, 42));
-    loadFrames(duckFrames, "Hat_Duck", 2, QSize(72, 28));
-
-  } else if (skin == 2) {
-    // Santa
-    dinoStartSprite.load(":/images/images/Santa_Start.png");
-    dinoJumpSprite.load(":/images/images/Santa_Jump.png");
-    dinoDeadSprite.load(":/images/images/Santa_Dead.png");
-    dinoStartSprite = dinoStartSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                             Qt::SmoothTransformation);
-    dinoJumpSprite = dinoJumpSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-    dinoDeadSprite = dinoDeadSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-
-    loadFrames(runFrames, "Santa_Run", 2, QSize(38, 42));
-    loadFrames(duckFrames, "Santa_Duck", 2, QSize(72, 28));
-
-  } else if (skin == 3) {
-    // Cowboy
-    dinoStartSprite.load(":/images/images/Cowboy_Start.png");
-    dinoJumpSprite.load(":/images/images/Cowboy_Jump.png");
-    dinoDeadSprite.load(":/images/images/Cowboy_Dead.png");
-    dinoStartSprite = dinoStartSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                             Qt::SmoothTransformation);
-    dinoJumpSprite = dinoJumpSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-    dinoDeadSprite = dinoDeadSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-
-    loadFrames(runFrames, "Cowboy_Run", 2, QSize(38, 42));
-    loadFrames(duckFrames, "Cowboy_Duck", 2, QSize(72, 28));
-
-  } else if (skin == 4) {
-    // Pirate
-    dinoStartSprite.load(":/images/images/Pirate_Start.png");
-    dinoJumpSprite.load(":/images/images/Pirate_Jump.png");
-    dinoDeadSprite.load(":/images/images/Pirate_Dead.png");
-    dinoStartSprite = dinoStartSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                             Qt::SmoothTransformation);
-    dinoJumpSprite = dinoJumpSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-    dinoDeadSprite = dinoDeadSprite.scaled(38, 42, Qt::KeepAspectRatio,
-                                           Qt::SmoothTransformation);
-
-    loadFrames(runFrames, "Pirate_Run", 2, QSize(38, 42));
-    loadFrames(duckFrames, "Pirate_Duck", 2, QSize(72, 28));
-  }
+  skinSprites = skinCache.get(skin);
+  game.setDinoMasks(skinSprites ? skinSprites->masks : nullptr);
+  // drop the RGB565 copies of the previous skin's dino, which would
+  // otherwise outlive its eviction from skinCache
+  sprites565.clear();
+  sprites565Built = false;
+}
+
+void dinosaur::buildNightSprites() {
+  largeCactusNightSprites.clear();
+  smallCactusNightSprites.clear();
+  for (const auto &pm : std::as_const(largeCactusSprites))
+    largeCactusNightSprites.push_back(toNightPixmap(pm));
+  for (const auto &pm : std::as_const(smallCactusSprites))
+    smallCactusNightSprites.push_back(toNightPixmap(pm));
+  birdNightSprite1 = toNightPixmap(birdSprite1);
+  birdNightSprite2 = toNightPixmap(birdSprite2);
+}
+
+void dinosaur::buildGroundStrips() {
+  if (groundSprite.isNull())
+    return;
+  QImage strip(width() + groundSprite.width(), groundSprite.height(),
+               QImage::Format_ARGB32_Premultiplied);
+  strip.fill(Qt::transparent);
+  QPainter sp(&strip);
+  for (int x = 0; x < strip.width(); x += groundSprite.width())
+    sp.drawPixmap(x, 0, groundSprite);
+  sp.end();
+
+  groundStrip = QPixmap::fromImage(strip);
+  groundNightStrip = toNightPixmap(groundStrip);
+}
+
+void dinosaur::buildAtlas() {
+  QVector<QPixmap> sprites;
+  sprites << largeCactusSprites << smallCactusSprites;
+  sprites << largeCactusNightSprites << smallCactusNightSprites;
+  sprites << birdSprite1 << birdSprite2 << birdNightSprite1 << birdNightSprite2;
+  sprites << cloudSprite << groundStrip << groundNightStrip;
+  atlas.build(sprites);
 }
 
 void dinosaur::resizeEvent(QResizeEvent *event) {
@@ -223,422 +404,345 @@ void dinosaur::resizeEvent(QResizeEvent *event) {
 }
 
 void dinosaur::reset() {
-  dino = QRect(40, groundY - 40, 36, 40); // x,y,w,h
-  vy = 0;
-  onGround = true;
-  isCrouching = false;
-  currentState = START;
-  cactus.clear();
-  cactusTypes.clear();
-  birds.clear();
-  clouds.clear();
-  groundX = 0.f;
-  speed = baseSpeed;
-  score = 0;
-  distanceTraveled = 0.f;
-  spawnTimer = 0.f;
-  isNight = false;
-  lastColorSwitch = 0;
-  groundOffset = 0.f;
-  gameOver = false;
-  started = false;
-  animTimer = 0.f;
-  currentRunFrame = currentDuckFrame = 0;
-  currentBirdFrame = 0;
+  SimPause pause(this);
+  game.reset();
+  input.clear();
+  KeyEvent key;
+  while (keyEvents.pop(key)) {
+  }
+  recording = Replay(currentSkinIndex, game.seed());
+  stepCount = 0;
+  replaying = false;
   btnRestart->hide();
-  clock.restart();
+  simJumps = seenJumps = 0;
+  simPoints = seenPoints = 0;
+  seenGameOver = false;
+  renderAlpha = 1.f;
+  lastSceneRegion = QRegion();
+  update();
 }
 
-void dinosaur::spawnCactus() {
-  // Randomly choose between large and small cactus
-  bool isLarge = QRandomGenerator::global()->bounded(2) == 0;
-  int spriteIndex = QRandomGenerator::global()->bounded(0, 3);
-
-  QPixmap cactusSprite;
-  if (isLarge) {
-    cactusSprite = largeCactusSprites[spriteIndex];
-    cactusTypes.push_back(spriteIndex); // 0-2 for large
-  } else {
-    cactusSprite = smallCactusSprites[spriteIndex];
-    cactusTypes.push_back(spriteIndex + 3); // 3-5 for small
+const QPixmap *dinosaur::currentDinoSprite(const RenderSnapshot &snap) const {
+  if (!skinSprites)
+    return nullptr;
+  const SkinSprites &s = *skinSprites;
+
+  switch (snap.state) {
+  case GameState::START:
+    return &s.start;
+  case GameState::JUMP:
+    return &s.jump;
+  case GameState::DEAD:
+    return &s.dead;
+  case GameState::DUCK:
+    return s.duck.isEmpty() ? nullptr
+                            : &s.duck[snap.duckFrame % s.duck.size()];
+  case GameState::RUN:
+  default:
+    return s.run.isEmpty() ? nullptr
+                           : &s.run[snap.runFrame % s.run.size()];
   }
-
-  int w = cactusSprite.width();
-  int h = cactusSprite.height();
-  int x = width() + QRandomGenerator::global()->bounded(0, 40);
-  int y = groundY - h;
-  cactus.push_back(QRect(x, y, w, h));
 }
 
-void dinosaur::spawnBird() {
-  int w = 28;
-  int h = 18;
-  int x = width() + QRandomGenerator::global()->bounded(0, 60);
+// Where to draw something moving left at vx pixels/s: between its position
+// before and after the last step, by the fraction of a step not simulated yet.
+QPoint dinosaur::renderPos(const GameRect &r, float vx) const {
+  float lag = (1.f - renderAlpha) * simStep;
+  return QPoint(qRound(r.x + vx * lag), qRound(r.y));
+}
 
-  int yLevel = QRandomGenerator::global()->bounded(0, 3);
-  int y;
-  if (yLevel == 0)
-    y = groundY - 60;
-  else if (yLevel == 1)
-    y = groundY - 90;
-  else
-    y = groundY - 120;
-  birds.push_back(QRect(x, y, w, h));
+QPoint dinosaur::dinoRenderPos(const RenderSnapshot &s) const {
+  const GameRect &dino = s.dino;
+  float y = s.prevDinoY + (dino.y - s.prevDinoY) * renderAlpha;
+  return QPoint(qRound(dino.x), qRound(y));
 }
 
-void dinosaur::spawnCloud() {
-  int w = cloudSprite.width();
-  int h = cloudSprite.height();
-  int x = width() + QRandomGenerator::global()->bounded(0, 50);
+// Everything that can move or change between two frames: sprites are taken at
+// their drawn size, the ground strip and score area as a whole.
+QRegion dinosaur::sceneRegion(const RenderSnapshot &s) const {
+  const GameConfig &cfg = game.config();
+  QRegion region;
+  const QPixmap *sprite = currentDinoSprite(s);
+  if (sprite)
+    region += QRect(dinoRenderPos(s), sprite->size());
+  for (const auto &r : s.cactus)
+    region += QRect(renderPos(r, s.speed), QSize(qCeil(r.w), qCeil(r.h)));
+  // covers both wing frames (wings up is drawn 7px higher)
+  for (const auto &b : s.birds)
+    region += QRect(renderPos(b, s.speed * cfg.birdSpeedFactor) -
+                        QPoint(0, 7),
+                    QSize(birdSprite1.width(), birdSprite1.height() + 7));
+  for (const auto &c : s.clouds)
+    region += QRect(renderPos(c, s.speed * cfg.cloudSpeedFactor),
+                    QSize(qCeil(c.w), qCeil(c.h)));
+  region += QRect(0, cfg.groundY - groundSprite.height() + 2, width(),
+                  groundSprite.height());
+  region += hudRect;
+  return region;
+}
 
-  // clouds appear at random heights above the ground
-  int y = QRandomGenerator::global()->bounded(20, 120);
-  clouds.push_back(QRect(x, y, w, h));
+void dinosaur::startReplay(const Replay &replay) {
+  SimPause pause(this);
+  setSkin(replay.skin());
+  reset();
+  game.reset(replay.seed());
+  playback = replay;
+  playbackCursor = ReplayCursor(&playback);
+  replaying = true;
 }
 
-void dinosaur::updateDinoState() {
-  if (currentState == JUMP)
-    return;
+uint32_t dinosaur::runReplayHeadless(const Replay &replay) {
+  SimPause pause(this);
+  setSkin(replay.skin());
+  reset();
+  uint32_t steps = runReplay(game, replay, simStep);
+  if (game.gameOver)
+    btnRestart->show();
+  update();
+  return steps;
+}
 
-  if (onGround && isCrouching) {
-    currentState = DUCK;
+// One step of dt simulating the time from startNs on, on the simulation
+// thread
+void dinosaur::step(float dt, int64_t startNs) {
+  TRACE_SCOPE("step");
+  GameInput in = input.take(startNs, simStepNs);
+  if (replaying) {
+    // keys are ignored; after the recorded steps the run goes on without
+    // input
+    in = playbackCursor.next();
   } else {
-    currentState = RUN;
+    recording.record(stepCount, in);
   }
-}
+  ++stepCount;
 
-void dinosaur::updateAnimation(float dt) {
-  if (runFrames.isEmpty() || duckFrames.isEmpty()) {
-    return;
+  unsigned events = game.step(in, dt);
+  if (events & EVENT_JUMP) {
+    ++simJumps;
+    simJumpPressNs = replaying ? 0 : input.jumpTimeNs();
+    simJumpStepNs = monotonicNs();
   }
-  animTimer += dt;
-  if (animTimer < animFrameDuration)
-    return;
-  animTimer -= animFrameDuration;
+  if (events & EVENT_POINT)
+    ++simPoints;
 
-  if (currentState == RUN) {
-    currentRunFrame = (currentRunFrame + 1) % runFrames.size();
-  } else {
-    currentDuckFrame = (currentDuckFrame + 1) % duckFrames.size();
+  if ((events & EVENT_HIT) && !replaying) {
+    recording.finish(stepCount);
+    if (!recording.save(lastRunFile.toStdString()))
+      qDebug() << "Could not write replay:" << lastRunFile;
   }
-
-  // Update bird animation
-  currentBirdFrame = (currentBirdFrame + 1) % 2;
 }
 
-void dinosaur::updatePhysics(float dt) {
-  if (!started) {
-    return;
+// Takes the newest snapshot for this frame, reacts to the steps since the
+// last one and schedules the repaint
+void dinosaur::tick() {
+  TRACE_SCOPE("tick");
+  if (simRunning)
+    snapshots.update();
+  const RenderSnapshot &s = snapshot();
+
+  if (s.jumps != seenJumps) {
+    seenJumps = s.jumps;
+    if (latencyJumps && s.jumpPressNs) {
+      latencyPressNs = s.jumpPressNs;
+      latencyToStep.add(s.jumpStepNs - latencyPressNs);
+    }
+#ifdef SOUND
+    if (sJump.isLoaded())
+      sJump.play();
+#endif
   }
-
-  // background moves toward left
-  int dx = (int)std::round(-speed * dt);
-  for (auto &r : cactus)
-    r.translate(dx, 0);
-  // move birds (faster than cactus)
-  int birdDx = (int)std::round(-speed * dt * 1.4f);
-  for (auto &b : birds)
-    b.translate(birdDx, 0);
-  // move clouds (slower than cactus)
-  for (auto &c : clouds)
-    c.translate(dx * 1.5, 0);
-
-  // ground pattern moves
-  groundOffset += speed * dt * 0.3f;
-  if (groundOffset > groundPatternSpacing)
-    groundOffset = std::fmod(groundOffset, groundPatternSpacing);
-
-  // update distance traveled and calculate score
-  distanceTraveled += speed * dt;
-  int newScore = (int)(distanceTraveled / 10.0f);
-
-  // play sound and increase speed when score increases by 100
-  if (newScore / 100 > score / 100) {
-    speed = std::min(maxSpeed, speed + 10.f);
+  if (s.points != seenPoints) {
+    seenPoints = s.points;
 #ifdef SOUND
-    if (sPoint.isLoaded()) {
+    if (sPoint.isLoaded())
       sPoint.play();
-    }
 #endif
   }
-  score = newScore;
-
-  // remove obstacles when they go off screen
-  for (int i = cactus.size() - 1; i >= 0; --i) {
-    if (cactus[i].right() < 0) {
-      cactus.remove(i);
-      cactusTypes.remove(i);
-    }
-  }
-  for (int i = birds.size() - 1; i >= 0; --i) {
-    if (birds[i].right() < 0) {
-      birds.remove(i);
-    }
-  }
-  for (int i = clouds.size() - 1; i >= 0; --i) {
-    if (clouds[i].right() < 0) {
-      clouds.remove(i);
+  bool ended = s.gameOver && !seenGameOver;
+  if (ended) {
+    seenGameOver = true;
+    btnRestart->show();
+#ifdef SOUND
+    if (sHit.isLoaded()) {
+      sHit.play();
     }
-  }
-
-  // dinosaur move vertically
-  if (!onGround) {
-    vy += gravity * dt;
-    dino.translate(0, (int)std::round(vy * dt));
-    if (dino.bottom() >= groundY) {
-      dino.moveBottom(groundY);
-      vy = 0.f;
-      onGround = true;
-
-      if (isCrouching) {
-        currentState = DUCK;
-      } else {
-        currentState = RUN;
-      }
+#endif
+    // Update high score if current score is higher
+    if (s.score > highScore) {
+      highScore = s.score;
     }
+    // game over image and dead sprite
+    update();
+    if (latencyJumps)
+      QTimer::singleShot(0, this, &dinosaur::reset);
   }
 
-  // dinosaur crouches
-  if (onGround && isCrouching) {
-    // Apply crouching state
-    int oldBottom = dino.bottom();
-    dino.setHeight(20);
-    dino.moveBottom(oldBottom);
+  // interpolate by how far the frame is past the snapshot
+  bool playing = s.started && !s.gameOver;
+  float lag = float(monotonicNs() - s.timeNs) / simStepNs;
+  renderAlpha = playing ? qBound(0.f, lag, 1.f) : 1.f;
+
+  // Nothing moves while waiting to start or after game over. While playing
+  // only the old and new positions of moving things are repainted.
+  TRACE_SCOPE("invalidate");
+  QRegion scene = sceneRegion(s);
+  if (s.isNight != lastNight) {
+    update();
+  } else if (s.started && !lastGameOver) {
+    update(scene | lastSceneRegion);
   }
+  lastSceneRegion = scene;
+  lastNight = s.isNight;
+  lastGameOver = s.gameOver;
 
-  updateDinoState();
-  updateAnimation(dt);
+  // the panel is redrawn every frame, Qt paints only what it exposes
+  if (fb && isVisible())
+    renderToFb();
 
-  // Day/night cycle based on score milestones
-  int initial = 200;
-  if (score >= initial) {
-    int milestone = ((score - initial) / 200) + 1;
-    if (milestone != lastColorSwitch) {
-      lastColorSwitch = milestone;
-      isNight = !isNight;
-    }
-  }
-
-  // create obstacles
-  spawnTimer -= dt;
-  if (spawnTimer <= 0.f) {
-    float obstacleType = QRandomGenerator::global()->bounded(1000) / 1000.f;
-
-    bool isBird = (obstacleType >= 0.8f);
-
-    if (isBird) {
-      spawnBird();
-    } else {
-      spawnCactus();
-    }
+  // last, the slots may reset the game and with it the snapshots
+  if (ended)
+    emit gameOverSignal(currentSkinIndex, s.score);
+}
 
-    // maybe spawn a cloud (about 20% chance)
-    float cloudChance = QRandomGenerator::global()->bounded(1000) / 1000.f;
-    if (cloudChance < 0.8f) {
-      spawnCloud();
-    }
+void dinosaur::paintEvent(QPaintEvent *event) {
+  TRACE_SCOPE("paintEvent");
+  QPainter p(this);
+  p.setClipRegion(event->region());
+  paintScene(p, event->rect());
 
-    float r = QRandomGenerator::global()->bounded(1000) / 1000.f;
-    float gap = spawnMin + r * (spawnMax - spawnMin);
-    // Adjust gap based on speed, and increase gap for birds since they move
-    // faster
-    float adjustedGap = gap - (speed - 180.f) / 600.f;
-    if (isBird) {
-      adjustedGap *=
-          1.3f; // Increase gap for birds to compensate for their faster speed
-    }
-    spawnTimer =
-        std::max(0.9f, adjustedGap); // Minimum gap increased to 0.9s for safety
+#ifdef LOAD_STATS
+  if (awaitingFirstFrame) {
+    awaitingFirstFrame = false;
+    qDebug() << "time to first frame:" << firstFrameTimer.elapsed() << "ms";
   }
+#endif
+
+  // the frame goes to the backing store once the painter is done
+  p.end();
+  frameShown();
+}
 
-  groundX -= speed * dt;
-  if (groundX <= -groundSprite.width())
-    groundX += groundSprite.width();
+// A frame with the current state is on its way to the screen
+void dinosaur::frameShown() {
+  if (!latencyPressNs)
+    return;
+  latencyToFrame.add(monotonicNs() - latencyPressNs);
+  latencyPressNs = 0;
+  if (int(latencyToFrame.count()) == latencyJumps)
+    emit latencyMeasured();
 }
 
-bool dinosaur::checkCollision() const {
-  const int MIN_OVERLAP = 125;
+// Draws the game (not the child buttons) within rect, on the widget or in
+// framebuffer mode on the framebuffer
+void dinosaur::paintScene(QPainter &p, const QRect &rect) {
+  const RenderSnapshot &s = snapshot();
+  const bool isNight = s.isNight;
 
-  for (const auto &c : cactus) {
-    QRect inter = dino.intersected(c);
-    if (inter.width() > 0 && inter.height() > 0) {
-      if (inter.width() * inter.height() > MIN_OVERLAP) {
-        return true;
-      }
-    }
+  QColor bg = isNight ? QColor(30, 30, 30) : Qt::white;
+  QColor fg = isNight ? Qt::white : Qt::black;
+  {
+    TRACE_SCOPE("paint.background");
+    p.fillRect(rect, bg);
   }
 
-  for (const auto &b : birds) {
-    QRect inter = dino.intersected(b);
-    if (inter.width() > 0 && inter.height() > 0) {
-      if (inter.width() * inter.height() > MIN_OVERLAP) {
-        return true;
-      }
-    }
+  // sprites are queued and submitted from the atlas in as few calls as
+  // possible
+  SpriteBatch batch(p, atlas);
+  if (skinSprites)
+    batch.addAtlas(skinSprites->atlas);
+  drawSprites(batch, s);
+  {
+    TRACE_SCOPE("paint.sprites");
+    batch.flush();
   }
 
-  return false;
+  paintHud(p, s);
 }
 
-void dinosaur::tick() {
-  float dt = clock.restart() / 1000.0f;
-  if (!gameOver) {
-    updatePhysics(dt);
-    if (started && checkCollision()) {
-      gameOver = true;
-      btnRestart->show();
-      currentState = DEAD;
-#ifdef SOUND
-      if (sHit.isLoaded()) {
-        sHit.play();
-      }
-#endif
-      // Update high score if current score is higher
-      if (score > highScore) {
-        highScore = score;
-      }
-      emit gameOverSignal(currentSkinIndex, score);
-    }
-  }
-  update();
+dinosaur::DrawStats dinosaur::renderSprites(QImage &image, bool batched) {
+  const RenderSnapshot &s = snapshot();
+  QPainter p(&image);
+  // sprites found in no atlas are drawn one by one
+  const SpriteAtlas noAtlas;
+  SpriteBatch batch(p, batched ? atlas : noAtlas);
+  if (batched && skinSprites)
+    batch.addAtlas(skinSprites->atlas);
+  drawSprites(batch, s);
+  batch.flush();
+  return DrawStats{batch.spriteCount(), batch.drawCallCount()};
 }
 
-void dinosaur::paintEvent(QPaintEvent *) {
-  QPainter p(this);
-  QColor bg = isNight ? QColor(30, 30, 30) : Qt::white;
-  QColor fg = isNight ? Qt::white : Qt::black;
-  p.fillRect(rect(), bg);
-
-  // draw ground sprite repeating
-  float gx = groundX;
-  while (gx < width()) {
-    p.drawPixmap((int)gx, groundY - groundSprite.height() + 2, groundSprite);
-    gx += groundSprite.width();
+// Ground, clouds, dino and obstacles, back to front. Batch is SpriteBatch
+// or SpriteBatch565.
+template <typename Batch>
+void dinosaur::drawSprites(Batch &batch, const RenderSnapshot &s) {
+  const GameConfig &cfg = game.config();
+  const bool isNight = s.isNight;
+  const float speed = s.speed;
+
+  // ground: one screen-wide window into the pre-tiled strip
+  const QPixmap &ground = isNight ? groundNightStrip : groundStrip;
+  if (!ground.isNull()) {
+    float scroll = s.groundScroll - speed * (1.f - renderAlpha) * simStep;
+    if (scroll < 0.f)
+      scroll += groundSprite.width();
+    batch.draw(0, cfg.groundY - ground.height() + 2, ground,
+               QRect(qRound(scroll) % groundSprite.width(), 0, width(),
+                     ground.height()));
   }
 
   // draw clouds (behind dinosaur and birds)
-  for (const auto &c : std::as_const(clouds)) {
-    p.drawPixmap(c.topLeft(), cloudSprite);
+  for (const auto &c : s.clouds) {
+    batch.draw(renderPos(c, speed * cfg.cloudSpeedFactor), cloudSprite);
   }
 
   // dinosaur
-  const QPixmap *sprite = nullptr;
-
-  switch (currentState) {
-  case START:
-    sprite = &dinoStartSprite;
-    break;
-
-  case JUMP:
-    sprite = &dinoJumpSprite;
-    break;
-
-  case DEAD:
-    sprite = &dinoDeadSprite;
-    break;
-
-  case DUCK:
-    sprite = &duckFrames[currentDuckFrame];
-    break;
-
-  case RUN:
-  default:
-    sprite = &runFrames[currentRunFrame];
-    break;
-  }
-
+  const QPixmap *sprite = currentDinoSprite(s);
   if (sprite)
-    p.drawPixmap(dino.topLeft(), *sprite);
+    batch.draw(dinoRenderPos(s), *sprite);
 
   // cactus
-  for (int i = 0; i < cactus.size(); ++i) {
-    const QRect &r = cactus[i];
-    int type = cactusTypes[i];
-
-    const QPixmap &cactusSprite =
-        (type < 3) ? largeCactusSprites[type] : smallCactusSprites[type - 3];
-
-    if (isNight) {
-      // Convert to grayscale for night time
-      QImage img =
-          cactusSprite.toImage().convertToFormat(QImage::Format_ARGB32);
-      for (int y = 0; y < img.height(); ++y) {
-        for (int x = 0; x < img.width(); ++x) {
-          QColor col = img.pixelColor(x, y);
-          if (col.alpha() > 0) { // Only modify non-transparent pixels
-            int gray = qGray(col.rgb());
-            // Lighten the gray value for better visibility
-            gray = qMin(255, gray + 100);
-            img.setPixelColor(x, y, QColor(gray, gray, gray, col.alpha()));
-          }
-        }
-      }
-      p.drawPixmap(r.topLeft(), QPixmap::fromImage(img));
-    } else {
-      p.drawPixmap(r.topLeft(), cactusSprite);
-    }
+  for (int i = 0; i < s.cactus.size(); ++i) {
+    const GameRect r = s.cactus[i];
+    int type = s.cactus.type(i);
+
+    const QVector<QPixmap> &large =
+        isNight ? largeCactusNightSprites : largeCactusSprites;
+    const QVector<QPixmap> &small =
+        isNight ? smallCactusNightSprites : smallCactusSprites;
+    const QPixmap &cactusSprite = (type < 3) ? large[type] : small[type - 3];
+
+    batch.draw(renderPos(r, speed), cactusSprite);
   }
 
   // birds
-  for (const auto &b : std::as_const(birds)) {
+  const int currentBirdFrame = s.birdFrame;
+  for (const auto &b : s.birds) {
     const QPixmap &birdSprite =
-        (currentBirdFrame == 0) ? birdSprite1 : birdSprite2;
+        (currentBirdFrame == 0) ? (isNight ? birdNightSprite1 : birdSprite1)
+                                : (isNight ? birdNightSprite2 : birdSprite2);
     // Bird 2 (wings up) needs to be slightly higher to align properly
     int yOffset = (currentBirdFrame == 0) ? 0 : -7;
 
-    if (isNight) {
-      // Convert to grayscale for night time
-      QImage img = birdSprite.toImage().convertToFormat(QImage::Format_ARGB32);
-      for (int y = 0; y < img.height(); ++y) {
-        for (int x = 0; x < img.width(); ++x) {
-          QColor col = img.pixelColor(x, y);
-          if (col.alpha() > 0) { // Only modify non-transparent pixels
-            int gray = qGray(col.rgb());
-            // Lighten the gray value for better visibility
-            gray = qMin(255, gray + 100);
-            img.setPixelColor(x, y, QColor(gray, gray, gray, col.alpha()));
-          }
-        }
-      }
-      p.drawPixmap(b.x(), b.y() + yOffset, QPixmap::fromImage(img));
-    } else {
-      p.drawPixmap(b.x(), b.y() + yOffset, birdSprite);
-    }
+    batch.draw(renderPos(b, speed * cfg.birdSpeedFactor) + QPoint(0, yOffset),
+               birdSprite);
   }
+}
+
+// Scores and the game over image
+void dinosaur::paintHud(QPainter &p, const RenderSnapshot &s) {
+  const bool isNight = s.isNight;
 
   // scores
-  QFont gameFont("Menlo", 15, QFont::Bold);
-  p.setFont(gameFont);
-  p.setPen(isNight ? Qt::white : QColor(83, 83, 83)); // Dark gray
-  p.setBrush(Qt::NoBrush);
-
-  QFontMetrics fm(gameFont);
-
-  // Display high score if it exists (after first game)
-  if (highScore > 0) {
-    // Format: "HI 00123 00045"
-    QString scoreDisplay = QString("HI %1 %2")
-                               .arg(highScore, 5, 10, QChar('0'))
-                               .arg(score, 5, 10, QChar('0'));
-    int displayWidth = fm.horizontalAdvance(scoreDisplay);
-    p.drawText(width() - displayWidth - 20, 30, scoreDisplay);
-  } else {
-    // current score
-    QString scoreText = QString("%1").arg(score, 5, 10, QChar('0'));
-    int scoreWidth = fm.horizontalAdvance(scoreText);
-    p.drawText(width() - scoreWidth - 20, 30, scoreText);
-  }
+  TRACE_SCOPE("paint.hud");
+  hud.draw(p, width() - 20, 30, s.score, highScore, isNight);
 
   // UI
-  QFont uiFont("Menlo", 15, QFont::Normal);
-  p.setFont(uiFont);
-  if (!started && !gameOver) {
+  if (!s.started && !s.gameOver) {
     // p.drawText(width() / 2 - 150, height() / 2 - 12, QStringLiteral("Press
     // SPACE/UP/W to start")); p.drawText(width() / 2 - 90, height() / 2 + 17,
     // QStringLiteral("DOWN/S to duck"));
-  } else if (gameOver) {
-    QFont gameOverFont("Menlo", 15, QFont::Normal);
-    p.setFont(gameOverFont);
+  } else if (s.gameOver) {
     // p.drawText(width() / 2 - 100, height() / 2, QStringLiteral("Press R to
     // restart"));
 
@@ -651,42 +755,120 @@ void dinosaur::paintEvent(QPaintEvent *) {
   }
 }
 
+static QImage::Format fbFormat(const FbDevice &fb) {
+  return fb.bitsPerPixel() == 16 ? QImage::Format_RGB16
+                                 : QImage::Format_RGB32;
+}
+
+void dinosaur::renderRgb565(QImage &frame) {
+  if (!sprites565Built)
+    buildSprites565();
+  const RenderSnapshot &s = snapshot();
+  {
+    TRACE_SCOPE("paint.background");
+    frame.fill(s.isNight ? QColor(30, 30, 30) : Qt::white);
+  }
+  {
+    TRACE_SCOPE("paint.sprites");
+    SpriteBatch565 batch(frame, sprites565);
+    drawSprites(batch, s);
+  }
+  QPainter p(&frame);
+  paintHud(p, s);
+}
+
+// Night sprites are dithered when DINO_FB_DITHER is set, their flat gray
+// tints band less on 16 bpp panels with it. Everything else, including the
+// dino frames of the skin, is converted when first drawn. Skin switches
+// start over.
+void dinosaur::buildSprites565() {
+  sprites565.clear();
+  bool dither = !qEnvironmentVariableIsEmpty("DINO_FB_DITHER");
+  for (const auto &pm : std::as_const(largeCactusNightSprites))
+    sprites565.add(pm, dither);
+  for (const auto &pm : std::as_const(smallCactusNightSprites))
+    sprites565.add(pm, dither);
+  sprites565.add(birdNightSprite1, dither);
+  sprites565.add(birdNightSprite2, dither);
+  sprites565.add(groundNightStrip, dither);
+  sprites565Built = true;
+}
+
+void dinosaur::renderToFb() {
+  TRACE_SCOPE("renderToFb");
+  {
+    // painted in place, the image does not own the pixels; the game covers
+    // the top left of the panel
+    QRect area = rect().intersected(QRect(0, 0, fb->width(), fb->height()));
+    QImage frame(fb->backBuffer(), area.width(), area.height(), fb->stride(),
+                 fbFormat(*fb));
+    // 16 bpp panels are composed in 16 bits, skipping Qt's 32-bit pipeline
+    if (frame.format() == QImage::Format_RGB16) {
+      renderRgb565(frame);
+    } else {
+      QPainter p(&frame);
+      paintScene(p, area);
+    }
+    // Qt draws the buttons only on its own surface
+    QPainter p(&frame);
+    for (QPushButton *b : {btnReturn, btnRestart})
+      if (b->isVisibleTo(this))
+        b->render(&p, b->pos(), QRegion(), QWidget::DrawChildren);
+  }
+  fb->present();
+  frameShown();
+}
+
+QImage dinosaur::fbFrame() const {
+  if (!fb)
+    return QImage();
+  return QImage(fb->frontBuffer(), fb->width(), fb->height(), fb->stride(),
+                fbFormat(*fb))
+      .copy();
+}
+
+void dinosaur::showEvent(QShowEvent *event) {
+  QWidget::showEvent(event);
+  startSim();
+}
+
+void dinosaur::hideEvent(QHideEvent *event) {
+  // the game waits while the menus are up
+  stopSim();
+  // the menus are drawn by Qt on the first page
+  if (fb)
+    fb->restore();
+  QWidget::hideEvent(event);
+}
+
+void dinosaur::measureLatency(int jumps) {
+  latencyJumps = jumps;
+  latencyPressNs = 0;
+  latencyToStep.clear();
+  latencyToFrame.clear();
+  frameClock.clearStats();
+  frameClock.setStatsEnabled(jumps > 0);
+}
+
+QString dinosaur::latencyReport() const {
+  return QString::fromStdString(latencyToStep.report("press to step")) +
+         "\n" +
+         QString::fromStdString(latencyToFrame.report("press to frame")) +
+         "\n" + QString::fromStdString(frameClock.report());
+}
+
 void dinosaur::keyPressEvent(QKeyEvent *e) {
   if (e->isAutoRepeat()) {
     QWidget::keyPressEvent(e);
     return;
   }
 
+  // jump and duck are applied by the simulation step covering now
   if (e->key() == Qt::Key_Space || e->key() == Qt::Key_Up ||
       e->key() == Qt::Key_W) {
-    if (!gameOver) {
-      if (!started) {
-        started = true;
-      }
-      if (onGround) {
-        onGround = false;
-        vy = jumpV;
-#ifdef SOUND
-        if (sJump.isLoaded()) {
-          sJump.play();
-        }
-#endif
-        currentState = JUMP;
-
-        int oldBottom = dino.bottom();
-        dino.setHeight(40);
-        dino.moveBottom(oldBottom);
-      }
-    }
+    press(InputLatch::JUMP, true, monotonicNs());
   } else if (e->key() == Qt::Key_Down || e->key() == Qt::Key_S) {
-    if (!gameOver) {
-      if (!isCrouching) {
-        isCrouching = true;
-      }
-      // accelerate falling to ground
-      if (!onGround)
-        vy += 300.f;
-    }
+    press(InputLatch::DUCK, true, monotonicNs());
   } else if (e->key() == Qt::Key_R) {
     reset();
   } else if (e->key() == Qt::Key_Escape) {
@@ -701,14 +883,11 @@ void dinosaur::keyReleaseEvent(QKeyEvent *e) {
     return;
   }
 
-  if (e->key() == Qt::Key_Down || e->key() == Qt::Key_S) {
-    if (isCrouching) {
-      isCrouching = false;
-      // Return to normal height
-      int oldBottom = dino.bottom();
-      dino.setHeight(40);
-      dino.moveBottom(oldBottom);
-    }
+  if (e->key() == Qt::Key_Space || e->key() == Qt::Key_Up ||
+      e->key() == Qt::Key_W) {
+    press(InputLatch::JUMP, false, monotonicNs());
+  } else if (e->key() == Qt::Key_Down || e->key() == Qt::Key_S) {
+    press(InputLatch::DUCK, false, monotonicNs());
   }
   QWidget::keyReleaseEvent(e);
 }
@@ -1,13 +1,31 @@
 #ifndef DINOSAUR_H
 #define DINOSAUR_H
 
+#include "fbDevice.h"
+#include "frameScheduler.h"
+#include "gameState.h"
+#include "inputLatch.h"
+#include "latencyStats.h"
+#include "renderSnapshot.h"
+#include "replay.h"
+#include "scoreHud.h"
+#include "skinCache.h"
+#include "spriteAtlas.h"
+#include "spriteBatch565.h"
+#include "spscQueue.h"
+#include "tripleBuffer.h"
 #include <QElapsedTimer>
 #include <QPixmap>
 #include <QPushButton>
 #include <QRect>
-#include <QTimer>
+#include <QRegion>
+#include <QSharedPointer>
+#include <QSocketNotifier>
 #include <QVector>
 #include <QWidget>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 // #define SOUND
 
@@ -19,11 +37,53 @@ class dinosaur : public QWidget {
   Q_OBJECT
 public:
   explicit dinosaur(QWidget *parent = nullptr);
+  ~dinosaur();
   void reset();
   void setSkin(int skin);
 
+  // Plays a recorded run in real time, jump and duck keys are ignored
+  void startReplay(const Replay &replay);
+  // Plays a recorded run without waiting for the clock or painting,
+  // returns the number of steps run
+  uint32_t runReplayHeadless(const Replay &replay);
+
+  // Game state behind the widget, for tools and benchmarks. Only while the
+  // widget is hidden: then the simulation thread is stopped and frames are
+  // drawn from this state directly.
+  GameState &state() { return game; }
+
+  // Latency mode: times each jump from its key or button press to the step
+  // applying it and to the end of the paintEvent that first shows it. Runs
+  // that end are restarted. Emits latencyMeasured() after `jumps` jumps.
+  // Frame timing jitter is collected meanwhile and is part of the report.
+  void measureLatency(int jumps);
+  QString latencyReport() const;
+
+  // Framebuffer mode, when DINO_FB names a framebuffer (see FbDevice):
+  // while the widget is visible tick() draws each frame straight into it
+  // instead of going through Qt. Menus and other widgets stay on Qt.
+  bool hasFb() const { return fb != nullptr; }
+  void renderToFb();
+  // Frame on screen in the framebuffer
+  QImage fbFrame() const;
+  // Draws the game into an RGB565 image (QImage::Format_RGB16) the way
+  // paintEvent does, but with the sprites composited in 16 bits; used for
+  // 16 bpp framebuffers
+  void renderRgb565(QImage &frame);
+
+  // Draws only the sprites of the game into image, from the atlases through
+  // SpriteBatch or, unbatched, with one drawPixmap per sprite as before
+  // batching. For the benchmarks, returns what the batch counted.
+  struct DrawStats {
+    int sprites;
+    int drawCalls;
+  };
+  DrawStats renderSprites(QImage &image, bool batched);
+
 protected:
   void paintEvent(QPaintEvent *) override;
+  void showEvent(QShowEvent *) override;
+  void hideEvent(QHideEvent *) override;
   void keyPressEvent(QKeyEvent *) override;
   void keyReleaseEvent(QKeyEvent *e) override;
 
@@ -33,96 +93,169 @@ private slots:
 signals:
   void exitToMenu();
   void gameOverSignal(int skin, int score);
+  void latencyMeasured();
 
 private:
-  enum DinoState { RUN, DUCK, START, JUMP, DEAD };
-
-  void spawnCactus();
-  void spawnBird();
-  void spawnCloud();
-  void updateDinoState();
-  void updatePhysics(float dt);
-  bool checkCollision() const;
-  void updateAnimation(float dt);
+  // Stops the simulation thread while it lives so the GUI thread can change
+  // the game; nests
+  class SimPause {
+  public:
+    explicit SimPause(dinosaur *d);
+    ~SimPause();
+
+  private:
+    dinosaur *d;
+  };
+
+  void startSim();
+  void stopSim();
+  void sendSim(int command);
+  void simulate();
+  void step(float dt, int64_t startNs);
+  void takeSnapshot(RenderSnapshot &s, int64_t timeNs) const;
+  void publish(int64_t timeNs);
+  const RenderSnapshot &snapshot();
+  void press(InputLatch::Button button, bool down, int64_t timeNs);
+
+  void paintScene(QPainter &p, const QRect &rect);
+  template <typename Batch>
+  void drawSprites(Batch &batch, const RenderSnapshot &s);
+  void paintHud(QPainter &p, const RenderSnapshot &s);
+  void frameShown();
+  void buildNightSprites();
+  void buildAtlas();
+  void buildGroundStrips();
+  void buildSprites565();
+  const QPixmap *currentDinoSprite(const RenderSnapshot &s) const;
+  QRegion sceneRegion(const RenderSnapshot &s) const;
+  QPoint renderPos(const GameRect &r, float vx) const;
+  QPoint dinoRenderPos(const RenderSnapshot &s) const;
   void resizeEvent(QResizeEvent *event) override;
 
   // control buttons
   QPushButton *btnReturn;
   QPushButton *btnRestart;
 
-  // dinosaur
-  QRect dino;
-  float vy = 0.f;
-  bool onGround = true;
-  bool isCrouching = false;
-  DinoState currentState = RUN;
-  bool gameOver = false;
-  bool started = false;
+  // game rules and state, stepped on the simulation thread while the widget
+  // is shown. Keys and buttons are queued to that thread and wait in the
+  // latch for the step covering the time they were pressed.
+  GameState game;
+  InputLatch input;
+  struct KeyEvent {
+    InputLatch::Button button;
+    bool down;
+    int64_t timeNs;
+  };
+  SpscQueue<KeyEvent, 64> keyEvents;
+
+  // every run is recorded and saved to lastRunFile when it ends; a replay
+  // being played feeds the steps instead of the keyboard (cursor past the
+  // end gives empty input)
+  const QString lastRunFile = "last_run.replay";
+  Replay recording;
+  uint32_t stepCount = 0;
+  Replay playback;
+  ReplayCursor playbackCursor;
+  bool replaying = false;
 
   // sprites
   QPixmap gameOverImage;
-  QPixmap dinoStartSprite;
-  QPixmap dinoJumpSprite;
-  QPixmap dinoDeadSprite;
-  QVector<QPixmap> runFrames;
-  QVector<QPixmap> duckFrames;
-  int currentRunFrame = 0;
-  int currentDuckFrame = 0;
-  float animTimer = 0.f;
-  float animFrameDuration = 0.08f;
+  SkinCache skinCache;
+  QSharedPointer<const SkinSprites> skinSprites; // current skin
 
   // bird sprites
   QPixmap birdSprite1;
   QPixmap birdSprite2;
-  int currentBirdFrame = 0;
 
   // cactus sprites
   QVector<QPixmap> largeCactusSprites;
   QVector<QPixmap> smallCactusSprites;
-  QVector<int> cactusTypes; // Track which sprite to use for each cactus
+
+  // night palette variants, built once when the sprites are loaded
+  QVector<QPixmap> largeCactusNightSprites;
+  QVector<QPixmap> smallCactusNightSprites;
+  QPixmap birdNightSprite1;
+  QPixmap birdNightSprite2;
+
+  // skin independent sprites packed into one sheet, the dino frames are in
+  // the atlas of the current skin
+  SpriteAtlas atlas;
 
   // clouds
-  QVector<QRect> clouds;
   QPixmap cloudSprite;
 
-  // ground tile sprite
+  // ground tile sprite, pre-tiled into strips one tile wider than the
+  // screen and drawn at a scroll offset in [0, tile width)
   QPixmap groundSprite;
-  float groundX = 0.f;
+  QPixmap groundStrip;
+  QPixmap groundNightStrip;
 
-  // obstacles
-  QVector<QRect> cactus;
-  QVector<QRect> birds;
+  // framebuffer mode, null when off
+  std::unique_ptr<FbDevice> fb;
+  // RGB565 copies of the sprites for renderRgb565()
+  Sprite565Cache sprites565;
+  bool sprites565Built = false;
 
-  // timers
-  QTimer frame;
-  QElapsedTimer clock;
+  // score display, pre-rendered digits
+  ScoreHud hud;
 
-  // game parameters
-  float speed = 200.f;
-  const float baseSpeed = 200.f;
-  const float maxSpeed = 420.f;
-  int score = 0;
-  int highScore = 0;
-  float distanceTraveled = 0.f;
-  float spawnTimer = 0.f;
-  float spawnMin = 1.0f;
-  float spawnMax = 1.8f;
+  // partial repaint: area covered by moving things on the last frame
+  QRegion lastSceneRegion;
+  QRect hudRect;
+
+  // frames: tick() runs at each deadline of the scheduler, on a grid at the
+  // display refresh rate (DINO_REFRESH_HZ, default 60)
+  FrameScheduler frameClock;
+  QSocketNotifier *frameNotifier = nullptr;
 
-  // physics constants
-  const int groundY = 200;
-  const float gravity = 2400.f;
-  const float jumpV = -700.f;
+  // fixed step simulation on its own thread: a step of simStep ends at each
+  // deadline of a 120 Hz grid, and after each wakeup the state is published
+  // as a snapshot. Frames draw the newest snapshot, interpolated by how far
+  // the clock is past its time. After a stall only the last
+  // maxCatchUpSteps steps are run.
+  const float simStep = 1.f / 120.f;
+  const int64_t simStepNs = 1000000000 / 120;
+  const int maxCatchUpSteps = 8;
+  // The thread lives from the first startSim() to the destructor; stopSim()
+  // parks it until the next startSim()
+  enum SimCommand { SIM_RUN, SIM_PAUSE, SIM_PAUSED, SIM_QUIT };
+  std::thread simThread;
+  std::atomic<int> simCommand{SIM_PAUSED};
+  int simWakeFd = -1; // eventfd, GUI -> simulate(): simCommand changed
+  int simAckFd = -1;  // eventfd, simulate() -> GUI: paused
+  bool simRunning = false;
+  int simPauses = 0;
+  TripleBuffer<RenderSnapshot> snapshots;
+  RenderSnapshot localSnapshot; // of game, while the thread is stopped
+  float renderAlpha = 1.f;
 
-  // day / night cycle
-  bool isNight = false;
-  int lastColorSwitch = 0; // last score for color switch
+  // simulation thread only: event counts for the snapshots
+  uint32_t simJumps = 0;
+  uint32_t simPoints = 0;
+  int64_t simJumpPressNs = 0;
+  int64_t simJumpStepNs = 0;
 
-  // ground pattern
-  float groundOffset = 0.f;
-  float groundPatternSpacing = 20.f;
+  // GUI thread: events of the run already handled, from the snapshots
+  uint32_t seenJumps = 0;
+  uint32_t seenPoints = 0;
+  bool seenGameOver = false;
+  bool lastNight = false;    // of the last frame
+  bool lastGameOver = false; // of the last frame
 
+  int highScore = 0;
   int currentSkinIndex = 0;
 
+  // latency mode, see measureLatency()
+  int latencyJumps = 0;       // 0 when off
+  int64_t latencyPressNs = 0; // jump applied but not painted yet
+  LatencyStats latencyToStep;
+  LatencyStats latencyToFrame;
+
+#ifdef LOAD_STATS
+  QElapsedTimer firstFrameTimer;
+  bool awaitingFirstFrame = false;
+#endif
+
 #ifdef SOUND
   QSoundEffect sJump;
   QSoundEffect sHit;
@@ -0,0 +1,156 @@
+#include "fbDevice.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FbDevice::~FbDevice() { close(); }
+
+bool FbDevice::fail(const std::string &message) {
+  lastError = message;
+  if (errno)
+    lastError += std::string(": ") + std::strerror(errno);
+  close();
+  return false;
+}
+
+bool FbDevice::open(const std::string &spec) {
+  close();
+  lastError.clear();
+
+  // "<path>:<w>x<h>x<bpp>" is a file standing in for a device
+  std::string path = spec;
+  int fileW = 0, fileH = 0, fileBpp = 0;
+  size_t colon = spec.rfind(':');
+  if (colon != std::string::npos &&
+      std::sscanf(spec.c_str() + colon + 1, "%dx%dx%d", &fileW, &fileH,
+                  &fileBpp) == 3)
+    path = spec.substr(0, colon);
+
+  errno = 0;
+  int flags = O_RDWR | O_CLOEXEC | (fileBpp ? O_CREAT : 0);
+  fd = ::open(path.c_str(), flags, 0644);
+  if (fd < 0)
+    return fail("cannot open " + path);
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+    return fail("cannot stat " + path);
+  if (S_ISCHR(st.st_mode)) {
+    fb_var_screeninfo var;
+    fb_fix_screeninfo fix;
+    if (ioctl(fd, FBIOGET_VSCREENINFO, &var) < 0 ||
+        ioctl(fd, FBIOGET_FSCREENINFO, &fix) < 0)
+      return fail(path + " is not a framebuffer");
+    bool rgb565 = var.bits_per_pixel == 16 && var.red.offset == 11 &&
+                  var.green.offset == 5 && var.blue.offset == 0;
+    bool xrgb = var.bits_per_pixel == 32 && var.red.offset == 16 &&
+                var.green.offset == 8 && var.blue.offset == 0;
+    errno = 0;
+    if (!rgb565 && !xrgb)
+      return fail(path + ": unsupported pixel format");
+
+    // a second page to pan to, if the driver has or can make the room
+    if (var.yres_virtual < 2 * var.yres) {
+      fb_var_screeninfo want = var;
+      want.yres_virtual = 2 * var.yres;
+      if (ioctl(fd, FBIOPUT_VSCREENINFO, &want) == 0)
+        ioctl(fd, FBIOGET_VSCREENINFO, &var);
+    }
+    xres = var.xres;
+    yres = var.yres;
+    bpp = var.bits_per_pixel;
+    lineBytes = fix.line_length;
+    panning = var.yres_virtual >= 2 * var.yres &&
+              fix.smem_len >= size_t(2) * yres * lineBytes &&
+              fix.ypanstep != 0;
+    mapSize = fix.smem_len;
+  } else {
+    errno = 0;
+    if (fileW <= 0 || fileH <= 0 || (fileBpp != 16 && fileBpp != 32))
+      return fail(path + " needs a mode, e.g. " + path + ":480x272x16");
+    xres = fileW;
+    yres = fileH;
+    bpp = fileBpp;
+    lineBytes = xres * bpp / 8;
+    mapSize = size_t(yres) * lineBytes;
+    if (size_t(st.st_size) != mapSize && ftruncate(fd, mapSize) < 0)
+      return fail("cannot resize " + path);
+  }
+
+  void *m = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (m == MAP_FAILED)
+    return fail("cannot map " + path);
+  map = static_cast<uint8_t *>(m);
+
+  if (panning) {
+    pan(0);
+    backPage = 1;
+  } else {
+    shadow.assign(size_t(yres) * lineBytes, 0);
+  }
+  return true;
+}
+
+void FbDevice::close() {
+  if (map) {
+    restore();
+    munmap(map, mapSize);
+  }
+  if (fd >= 0)
+    ::close(fd);
+  map = nullptr;
+  fd = -1;
+  panning = false;
+  shadow.clear();
+}
+
+uint8_t *FbDevice::backBuffer() {
+  if (!map)
+    return nullptr;
+  return panning ? map + size_t(backPage) * yres * lineBytes : shadow.data();
+}
+
+const uint8_t *FbDevice::frontBuffer() const {
+  if (!map)
+    return nullptr;
+  return panning ? map + size_t(1 - backPage) * yres * lineBytes : map;
+}
+
+void FbDevice::present() {
+  if (!map)
+    return;
+  if (panning) {
+    // wait for the vertical blank where the driver supports it, so the
+    // page flips between two scanouts
+    uint32_t screen = 0;
+    ioctl(fd, FBIO_WAITFORVSYNC, &screen);
+    pan(backPage);
+    backPage = 1 - backPage;
+  } else {
+    std::memcpy(map, shadow.data(), shadow.size());
+  }
+}
+
+void FbDevice::restore() {
+  if (panning && backPage == 0) {
+    // page 1 is on screen, bring back page 0 with the last frame
+    size_t page = size_t(yres) * lineBytes;
+    std::memcpy(map, map + page, page);
+    pan(0);
+    backPage = 1;
+  }
+}
+
+void FbDevice::pan(int page) {
+  fb_var_screeninfo var;
+  if (ioctl(fd, FBIOGET_VSCREENINFO, &var) < 0)
+    return;
+  var.xoffset = 0;
+  var.yoffset = page * yres;
+  ioctl(fd, FBIOPAN_DISPLAY, &var);
+}
@@ -0,0 +1,60 @@
+#ifndef FBDEVICE_H
+#define FBDEVICE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A Linux framebuffer mapped for drawing whole frames without Qt.
+//
+// spec is a device such as "/dev/fb0", or a regular file with its mode,
+// "<path>:<width>x<height>x<bpp>", which is grown to one frame and stands
+// in for the device (tests, frame dumps). Frames are drawn into
+// backBuffer() and shown by present():
+//  - when the device has room for two frames (yres_virtual, which open()
+//    tries to double), present() pans to the back page and the pages swap;
+//  - otherwise backBuffer() is plain memory that present() copies to the
+//    screen with one memcpy.
+// Only 16 bpp RGB565 and 32 bpp XRGB8888 are supported.
+class FbDevice {
+public:
+  FbDevice() = default;
+  ~FbDevice();
+  FbDevice(const FbDevice &) = delete;
+  FbDevice &operator=(const FbDevice &) = delete;
+
+  bool open(const std::string &spec);
+  void close();
+  bool isOpen() const { return map != nullptr; }
+  // Why open() failed
+  const std::string &error() const { return lastError; }
+
+  int width() const { return xres; }
+  int height() const { return yres; }
+  int bitsPerPixel() const { return bpp; }
+  int stride() const { return lineBytes; } // bytes per row
+  bool isPanning() const { return panning; }
+
+  uint8_t *backBuffer();
+  void present();
+  // Frame on screen, i.e. the last one presented
+  const uint8_t *frontBuffer() const;
+  // Shows the first page again, where other framebuffer users (Qt's
+  // linuxfb) draw
+  void restore();
+
+private:
+  bool fail(const std::string &message);
+  void pan(int page);
+
+  int fd = -1;
+  uint8_t *map = nullptr;
+  size_t mapSize = 0;
+  int xres = 0, yres = 0, bpp = 0, lineBytes = 0;
+  bool panning = false;
+  int backPage = 1;           // when panning
+  std::vector<uint8_t> shadow; // back buffer when not panning
+  std::string lastError;
+};
+
+#endif // FBDEVICE_H
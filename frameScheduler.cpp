@@ -0,0 +1,144 @@
+#include "frameScheduler.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+int64_t nowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+timespec toTimespec(int64_t ns) {
+  timespec ts;
+  ts.tv_sec = ns / 1000000000;
+  ts.tv_nsec = ns % 1000000000;
+  return ts;
+}
+
+} // namespace
+
+FrameScheduler::FrameScheduler(double hz, SkipPolicy policy)
+    : hz(hz > 0 ? hz : 60.0), policy(policy) {}
+
+FrameScheduler::~FrameScheduler() { stop(); }
+
+void FrameScheduler::setRefreshRate(double rate) {
+  if (rate <= 0 || rate == hz)
+    return;
+  // the grid restarts at the next deadline so that one keeps its time
+  if (running) {
+    originNs = deadline(index);
+    index = 0;
+  }
+  hz = rate;
+}
+
+// Computed from the origin each time so the fractional period (16.67 ms at
+// 60 Hz) does not accumulate rounding error
+int64_t FrameScheduler::deadline(int64_t i) const {
+  return originNs + std::llround(double(i) * 1e9 / hz);
+}
+
+bool FrameScheduler::start() {
+  stop();
+  timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timerFd < 0)
+    return false;
+  originNs = nowNs();
+  index = 1;
+  lastWakeNs = 0;
+  running = true;
+  arm();
+  return true;
+}
+
+void FrameScheduler::stop() {
+  if (timerFd >= 0)
+    close(timerFd);
+  timerFd = -1;
+  running = false;
+}
+
+void FrameScheduler::arm() {
+  if (timerFd < 0)
+    return;
+  itimerspec spec = {};
+  spec.it_value = toTimespec(deadline(index));
+  timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+FrameScheduler::Frame FrameScheduler::frame() {
+  uint64_t expirations;
+  while (read(timerFd, &expirations, sizeof(expirations)) < 0 &&
+         errno == EINTR) {
+  }
+  Frame f = advance(nowNs());
+  arm();
+  return f;
+}
+
+FrameScheduler::Frame FrameScheduler::wait() {
+  if (!running) {
+    originNs = nowNs();
+    index = 1;
+    lastWakeNs = 0;
+    running = true;
+  }
+  timespec at = toTimespec(deadline(index));
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, nullptr) ==
+         EINTR) {
+  }
+  return advance(nowNs());
+}
+
+// Takes the frame due at deadline(index) and moves index to the next one
+FrameScheduler::Frame FrameScheduler::advance(int64_t now) {
+  Frame f{deadline(index), now, 0};
+  int64_t next = index + 1;
+  if (now >= deadline(next)) {
+    if (policy == SKIP_MISSED) {
+      // first deadline after now
+      int64_t at = int64_t(std::floor(double(now - originNs) * hz / 1e9)) + 1;
+      while (deadline(at) <= now)
+        ++at;
+      f.skipped = int(at - next);
+      next = at;
+    } else {
+      f.skipped = int(std::floor(double(now - f.deadlineNs) * hz / 1e9));
+      originNs = now;
+      next = 1;
+    }
+  }
+  index = next;
+
+  skippedCount += f.skipped;
+  if (stats) {
+    late.add(now - f.deadlineNs);
+    if (lastWakeNs)
+      interval.add(now - lastWakeNs);
+  }
+  lastWakeNs = now;
+  return f;
+}
+
+void FrameScheduler::clearStats() {
+  late.clear();
+  interval.clear();
+  skippedCount = 0;
+  lastWakeNs = 0;
+}
+
+std::string FrameScheduler::report() const {
+  char skipped[96];
+  std::snprintf(skipped, sizeof(skipped),
+                "skipped frames: %llu at %.2f Hz",
+                (unsigned long long)skippedCount, hz);
+  return late.report("frame lateness") + "\n" +
+         interval.report("frame interval") + "\n" + skipped;
+}
@@ -0,0 +1,87 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include "latencyStats.h"
+#include <cstdint>
+#include <string>
+
+// Frame deadlines on a fixed grid of CLOCK_MONOTONIC times, one per refresh
+// of a display running at refreshRate() Hz. Deadlines are absolute, so late
+// wakeups do not push the following frames back and the rate does not drift
+// the way a relative interval timer does.
+//
+// Two ways to wait:
+//  - start() arms a timerfd for the next deadline; fd() becomes readable at
+//    the deadline (for an event loop) and frame() takes the frame and arms
+//    the next one;
+//  - wait() sleeps until the next deadline with clock_nanosleep().
+//
+// A frame that starts a whole period or more late has missed deadlines;
+// what happens to them is the SkipPolicy.
+class FrameScheduler {
+public:
+  enum SkipPolicy {
+    // missed deadlines are dropped, the next frame stays on the grid
+    SKIP_MISSED,
+    // the grid restarts from the late frame, one period after it
+    RESYNC,
+  };
+
+  struct Frame {
+    int64_t deadlineNs; // when the frame was due
+    int64_t wakeNs;     // when it started
+    int skipped;        // deadlines missed since the last frame
+  };
+
+  explicit FrameScheduler(double hz = 60.0, SkipPolicy policy = SKIP_MISSED);
+  ~FrameScheduler();
+  FrameScheduler(const FrameScheduler &) = delete;
+  FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+  // Takes effect from the next deadline on
+  void setRefreshRate(double hz);
+  double refreshRate() const { return hz; }
+  void setSkipPolicy(SkipPolicy p) { policy = p; }
+  SkipPolicy skipPolicy() const { return policy; }
+
+  // Creates the timerfd with the first deadline one period from now.
+  // Returns false if it cannot be created.
+  bool start();
+  void stop();
+  int fd() const { return timerFd; }
+  // After fd() became readable
+  Frame frame();
+  // Sleeps until the next deadline
+  Frame wait();
+
+  // Jitter statistics, collected only when enabled: how late each frame
+  // started and the time between frame starts
+  void setStatsEnabled(bool on) { stats = on; }
+  void clearStats();
+  const LatencyStats &lateness() const { return late; }
+  const LatencyStats &intervals() const { return interval; }
+  uint64_t skippedFrames() const { return skippedCount; }
+  // Lateness and interval percentiles and skipped frames, on three lines
+  std::string report() const;
+
+private:
+  int64_t deadline(int64_t index) const;
+  Frame advance(int64_t nowNs);
+  void arm();
+
+  double hz;
+  SkipPolicy policy;
+  int timerFd = -1;
+  // deadline i is at origin + i periods
+  int64_t originNs = 0;
+  int64_t index = 0;
+  bool running = false;
+
+  bool stats = false;
+  int64_t lastWakeNs = 0;
+  LatencyStats late;
+  LatencyStats interval;
+  uint64_t skippedCount = 0;
+};
+
+#endif // FRAMESCHEDULER_H
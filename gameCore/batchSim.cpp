@@ -0,0 +1,445 @@
+#include "batchSim.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float FAR_BELOW = 1e9f; // y of free obstacle slots
+const float DINO_X = 40.f;    // as in GameState::reset()
+
+int padded(int games) {
+  return (games + simd::WIDTH - 1) / simd::WIDTH * simd::WIDTH;
+}
+
+} // namespace
+
+BatchSim::BatchSim(int games, const GameConfig &config)
+    : cfg(config), count(std::max(0, games)), stride(padded(count)) {
+  rngs.resize(count);
+  seeds.assign(count, 0);
+  for (auto *v : {&dinoYs, &dinoHs, &prevYs, &vys, &stepDxs, &stepDys, &speeds,
+                  &distances, &spawnTimers, &animTimers, &scrolls, &inAir,
+                  &airDts, &landed, &checked})
+    v->assign(stride, 0.f);
+  for (auto *v : {&scores, &lastColorSwitches, &runFrames, &duckFrames,
+                  &birdFrames})
+    v->assign(count, 0);
+  states.assign(count, GameState::START);
+  lastEvents.assign(count, 0);
+  for (auto *v : {&onGround, &crouching, &over, &running, &night, &overflow,
+                  &jumpPhases})
+    v->assign(count, 0);
+
+  for (int k = 0; k < KIND_COUNT; ++k) {
+    xs[k].assign(SLOTS * stride, 0.f);
+    ys[k].assign(SLOTS * stride, FAR_BELOW);
+    ws[k].assign(SLOTS * stride, 0.f);
+    hs[k].assign(SLOTS * stride, 0.f);
+    heads[k].assign(count, 0);
+    counts[k].assign(count, 0);
+  }
+  types.assign(SLOTS * stride, 0);
+
+  for (int g = 0; g < count; ++g)
+    reset(g, 0);
+}
+
+const char *BatchSim::isa() { return simd::NAME; }
+
+void BatchSim::reset(int g, uint32_t seed) {
+  seeds[g] = seed;
+  rngs[g].seed(seed);
+  dinoHs[g] = float(cfg.dinoH);
+  dinoYs[g] = float(cfg.groundY - cfg.dinoH);
+  prevYs[g] = dinoYs[g];
+  stepDxs[g] = stepDys[g] = 0.f;
+  vys[g] = 0.f;
+  onGround[g] = true;
+  crouching[g] = false;
+  states[g] = GameState::START;
+  over[g] = false;
+  running[g] = false;
+  runFrames[g] = duckFrames[g] = birdFrames[g] = 0;
+  animTimers[g] = 0.f;
+  for (int k = 0; k < KIND_COUNT; ++k) {
+    for (int s = 0; s < SLOTS; ++s)
+      ys[k][s * stride + g] = FAR_BELOW;
+    heads[k][g] = counts[k][g] = 0;
+  }
+  scrolls[g] = 0.f;
+  speeds[g] = cfg.baseSpeed;
+  scores[g] = 0;
+  distances[g] = 0.f;
+  spawnTimers[g] = 0.f;
+  night[g] = false;
+  lastColorSwitches[g] = 0;
+  lastEvents[g] = 0;
+  overflow[g] = false;
+}
+
+int BatchSim::slot(int kind, int g, int i) const {
+  return ((heads[kind][g] + i) & (SLOTS - 1)) * stride + g;
+}
+
+GameRect BatchSim::obstacle(Kind kind, int g, int i) const {
+  int s = slot(kind, g, i);
+  return GameRect{xs[kind][s], ys[kind][s], ws[kind][s], hs[kind][s]};
+}
+
+// same sequence as GameState::bounded()
+int BatchSim::bounded(int g, int lo, int hi) {
+  uint64_t r = uint32_t(rngs[g]());
+  return lo + int((r * uint64_t(hi - lo)) >> 32);
+}
+
+void BatchSim::spawn(int kind, int g, const GameRect &r, int type) {
+  int s = slot(kind, g, counts[kind][g]);
+  xs[kind][s] = r.x;
+  ys[kind][s] = r.y;
+  ws[kind][s] = r.w;
+  hs[kind][s] = r.h;
+  if (kind == CACTUS)
+    types[s] = type;
+  if (counts[kind][g] == SLOTS) {
+    overflow[g] = true;
+    heads[kind][g] = (heads[kind][g] + 1) & (SLOTS - 1);
+  } else {
+    ++counts[kind][g];
+  }
+}
+
+void BatchSim::retireOffscreen(int kind, int g) {
+  while (counts[kind][g] > 0) {
+    int s = slot(kind, g, 0);
+    if (!(xs[kind][s] + ws[kind][s] < 0.f))
+      break;
+    ys[kind][s] = FAR_BELOW;
+    heads[kind][g] = (heads[kind][g] + 1) & (SLOTS - 1);
+    --counts[kind][g];
+  }
+}
+
+// GameState::applyInput()
+void BatchSim::applyInput(int g, const GameInput &input) {
+  if (input.jumpPressed && !over[g]) {
+    running[g] = true;
+    if (onGround[g]) {
+      onGround[g] = false;
+      vys[g] = cfg.jumpV;
+      jumpPhases[g] = input.jumpPhase;
+      lastEvents[g] |= EVENT_JUMP;
+      states[g] = GameState::JUMP;
+
+      float oldBottom = dinoYs[g] + dinoHs[g];
+      dinoHs[g] = cfg.dinoH;
+      dinoYs[g] = oldBottom - dinoHs[g];
+    }
+  }
+
+  if (input.duckPressed && !over[g]) {
+    crouching[g] = true;
+    if (!onGround[g])
+      vys[g] += cfg.fastFallV;
+  }
+
+  if (input.duckReleased && crouching[g]) {
+    crouching[g] = false;
+    float oldBottom = dinoYs[g] + dinoHs[g];
+    dinoHs[g] = cfg.dinoH;
+    dinoYs[g] = oldBottom - dinoHs[g];
+  }
+}
+
+// GameState::updatePhysics() up to the vertical motion
+void BatchSim::beginPhysics(int g, float dt) {
+  retireOffscreen(CACTUS, g);
+  retireOffscreen(BIRD, g);
+  retireOffscreen(CLOUD, g);
+
+  stepDxs[g] = -speeds[g] * dt;
+
+  distances[g] += speeds[g] * dt;
+  int newScore = (int)(distances[g] / 10.0f);
+  if (newScore / 100 > scores[g] / 100) {
+    speeds[g] = std::min(cfg.maxSpeed, speeds[g] + cfg.speedStep);
+    lastEvents[g] |= EVENT_POINT;
+  }
+  scores[g] = newScore;
+
+  prevYs[g] = dinoYs[g];
+  stepDys[g] = 0.f;
+  inAir[g] = onGround[g] ? 0.f : 1.f;
+  airDts[g] = airTime(dt, jumpPhases[g]);
+  jumpPhases[g] = 0;
+}
+
+// GameState::updatePhysics() after the vertical motion
+void BatchSim::endPhysics(int g, float dt) {
+  if (landed[g] != 0.f) {
+    onGround[g] = true;
+    states[g] = crouching[g] ? GameState::DUCK : GameState::RUN;
+  }
+
+  if (onGround[g] && crouching[g]) {
+    float oldBottom = dinoYs[g] + dinoHs[g];
+    dinoHs[g] = cfg.dinoDuckH;
+    dinoYs[g] = oldBottom - dinoHs[g];
+  }
+
+  if (states[g] != GameState::JUMP)
+    states[g] = (onGround[g] && crouching[g]) ? GameState::DUCK
+                                               : GameState::RUN;
+
+  animTimers[g] += dt;
+  if (animTimers[g] >= cfg.animFrameDuration) {
+    animTimers[g] -= cfg.animFrameDuration;
+    if (states[g] == GameState::RUN)
+      runFrames[g] = (runFrames[g] + 1) % cfg.runFrameCount;
+    else
+      duckFrames[g] = (duckFrames[g] + 1) % cfg.duckFrameCount;
+    birdFrames[g] = (birdFrames[g] + 1) % 2;
+  }
+
+  int initial = 200;
+  if (scores[g] >= initial) {
+    int milestone = ((scores[g] - initial) / 200) + 1;
+    if (milestone != lastColorSwitches[g]) {
+      lastColorSwitches[g] = milestone;
+      night[g] = !night[g];
+      lastEvents[g] |= EVENT_DAY_NIGHT;
+    }
+  }
+
+  spawnTimers[g] -= dt;
+  if (spawnTimers[g] <= 0.f) {
+    float obstacleType = bounded(g, 0, 1000) / 1000.f;
+    bool isBird = (obstacleType >= 1.f - cfg.birdChance);
+
+    if (isBird) {
+      float x = cfg.width + bounded(g, 0, 60);
+      int yLevel = bounded(g, 0, 3);
+      float y;
+      if (yLevel == 0)
+        y = cfg.groundY - 60;
+      else if (yLevel == 1)
+        y = cfg.groundY - 90;
+      else
+        y = cfg.groundY - 120;
+      spawn(BIRD, g, GameRect{x, y, float(cfg.birdW), float(cfg.birdH)}, 0);
+    } else {
+      bool isLarge = bounded(g, 0, 2) == 0;
+      int spriteIndex = bounded(g, 0, 3);
+      int type = isLarge ? spriteIndex : spriteIndex + 3;
+      float w = cfg.cactusW[type];
+      float h = cfg.cactusH[type];
+      float x = cfg.width + bounded(g, 0, 40);
+      float y = cfg.groundY - h;
+      spawn(CACTUS, g, GameRect{x, y, w, h}, type);
+    }
+
+    float cloudChance = bounded(g, 0, 1000) / 1000.f;
+    if (cloudChance < cfg.cloudChance) {
+      float x = cfg.width + bounded(g, 0, 50);
+      float y = bounded(g, 20, 120);
+      spawn(CLOUD, g, GameRect{x, y, float(cfg.cloudW), float(cfg.cloudH)},
+            0);
+    }
+
+    float r = bounded(g, 0, 1000) / 1000.f;
+    float gap = cfg.spawnMin + r * (cfg.spawnMax - cfg.spawnMin);
+    float adjustedGap = gap - (speeds[g] - 180.f) / 600.f;
+    if (isBird)
+      adjustedGap *= 1.3f;
+    spawnTimers[g] = std::max(cfg.minGap, adjustedGap);
+  }
+
+  scrolls[g] += speeds[g] * dt;
+  if (scrolls[g] >= cfg.groundTileW)
+    scrolls[g] = std::fmod(scrolls[g], (float)cfg.groundTileW);
+}
+
+// Every slot moves, live or not; games not running have a dx of 0
+void BatchSim::moveObstacles() {
+  const float factor[KIND_COUNT] = {1.f, cfg.birdSpeedFactor,
+                                    cfg.cloudSpeedFactor};
+  for (int k = 0; k < KIND_COUNT; ++k) {
+    const simd::vf f = simd::set1(factor[k]);
+    for (int g = 0; g < stride; g += simd::WIDTH) {
+      simd::vf dx = simd::load(&stepDxs[g]);
+      if (k != CACTUS)
+        dx = simd::mul(dx, f);
+      for (int s = 0; s < SLOTS; ++s) {
+        float *x = &xs[k][s * stride + g];
+        simd::store(x, simd::add(simd::load(x), dx));
+      }
+    }
+  }
+}
+
+// Gravity and landing for the games with the dino in the air
+void BatchSim::moveDino() {
+  const simd::vf zero = simd::set1(0.f);
+  const simd::vf one = simd::set1(1.f);
+  const simd::vf gravity = simd::set1(cfg.gravity);
+  const simd::vf ground = simd::set1(float(cfg.groundY));
+
+  for (int g = 0; g < stride; g += simd::WIDTH) {
+    simd::vm air = simd::gt(simd::load(&inAir[g]), zero);
+    simd::vf y = simd::load(&dinoYs[g]);
+    simd::vf h = simd::load(&dinoHs[g]);
+    simd::vf vy = simd::load(&vys[g]);
+    simd::vf airDt = simd::load(&airDts[g]);
+
+    simd::vf vy2 = simd::add(vy, simd::mul(gravity, airDt));
+    simd::vf y2 = simd::add(y, simd::mul(vy2, airDt));
+    simd::vm land = simd::ge(simd::add(y2, h), ground);
+    y2 = simd::select(land, simd::sub(ground, h), y2);
+    vy2 = simd::select(land, zero, vy2);
+
+    simd::store(&dinoYs[g], simd::select(air, y2, y));
+    simd::store(&vys[g], simd::select(air, vy2, vy));
+    simd::store(&stepDys[g],
+                simd::select(air, simd::sub(y2, y), simd::load(&stepDys[g])));
+    simd::store(&landed[g], simd::select(simd::both(air, land), one, zero));
+  }
+}
+
+// GameState::sweptHit() without masks
+bool BatchSim::sweptHit(int g, int kind, int s) const {
+  const GameRect dino{DINO_X, dinoYs[g], float(cfg.dinoW), dinoHs[g]};
+  const GameRect box{xs[kind][s], ys[kind][s], ws[kind][s], hs[kind][s]};
+  const float boxDx =
+      kind == CACTUS ? stepDxs[g] : stepDxs[g] * cfg.birdSpeedFactor;
+
+  const float vx = -boxDx;
+  const float vy = stepDys[g];
+  GameRect start = dino;
+  start.x += boxDx;
+  start.y -= stepDys[g];
+  return sweepBoxes(start, vx, vy, box, [&](float t) {
+    GameRect d = start;
+    d.x += vx * t;
+    d.y += vy * t;
+    return d.overlapArea(box) > cfg.minOverlap;
+  });
+}
+
+// Broad phase on vectors of games: the box swept by the dino over the step
+// (with a pixel of slack) against every slot. Candidates get the exact
+// swept test.
+void BatchSim::checkCollisions() {
+  const simd::vf zero = simd::set1(0.f);
+  const simd::vf slack = simd::set1(1.f);
+  const simd::vf dinoX = simd::set1(DINO_X);
+  const simd::vf dinoW = simd::set1(float(cfg.dinoW));
+  const simd::vf birdFactor = simd::set1(cfg.birdSpeedFactor);
+
+  for (int g0 = 0; g0 < stride; g0 += simd::WIDTH) {
+    simd::vm tested = simd::gt(simd::load(&checked[g0]), zero);
+    if (!simd::bits(tested))
+      continue;
+
+    simd::vf y = simd::load(&dinoYs[g0]);
+    simd::vf startY = simd::sub(y, simd::load(&stepDys[g0]));
+    simd::vf h = simd::load(&dinoHs[g0]);
+    simd::vf y0 = simd::sub(simd::min(y, startY), slack);
+    simd::vf y1 = simd::add(simd::add(simd::max(y, startY), h), slack);
+
+    for (int k : {CACTUS, BIRD}) {
+      simd::vf boxDx = simd::load(&stepDxs[g0]);
+      if (k == BIRD)
+        boxDx = simd::mul(boxDx, birdFactor);
+      simd::vf startX = simd::add(dinoX, boxDx);
+      simd::vf x0 = simd::sub(simd::min(dinoX, startX), slack);
+      simd::vf x1 =
+          simd::add(simd::add(simd::max(dinoX, startX), dinoW), slack);
+
+      for (int s = 0; s < SLOTS; ++s) {
+        const int i = s * stride + g0;
+        simd::vf bx = simd::load(&xs[k][i]);
+        simd::vf by = simd::load(&ys[k][i]);
+        simd::vm hit = simd::both(
+            simd::both(simd::gt(x1, bx),
+                       simd::lt(x0, simd::add(bx, simd::load(&ws[k][i])))),
+            simd::both(simd::gt(y1, by),
+                       simd::lt(y0, simd::add(by, simd::load(&hs[k][i])))));
+        int candidates = simd::bits(simd::both(hit, tested));
+        while (candidates) {
+          int lane = __builtin_ctz(unsigned(candidates));
+          candidates &= candidates - 1;
+          int g = g0 + lane;
+          if (!over[g] && sweptHit(g, k, i + lane)) {
+            over[g] = true;
+            states[g] = GameState::DEAD;
+            lastEvents[g] |= EVENT_HIT;
+          }
+        }
+      }
+    }
+  }
+}
+
+void BatchSim::step(const GameInput *inputs, float dt) {
+  for (int g = 0; g < count; ++g) {
+    lastEvents[g] = EVENT_NONE;
+    applyInput(g, inputs[g]);
+    bool active = running[g] && !over[g];
+    checked[g] = active ? 1.f : 0.f;
+    if (active) {
+      beginPhysics(g, dt);
+    } else {
+      stepDxs[g] = 0.f;
+      inAir[g] = 0.f;
+      jumpPhases[g] = 0;
+    }
+  }
+
+  moveObstacles();
+  moveDino();
+
+  for (int g = 0; g < count; ++g) {
+    if (checked[g] != 0.f)
+      endPhysics(g, dt);
+  }
+
+  checkCollisions();
+}
+
+bool BatchSim::matches(int g, const GameState &s) const {
+  bool same = s.dino.x == DINO_X && s.dino.y == dinoYs[g] &&
+              s.dino.w == float(cfg.dinoW) && s.dino.h == dinoHs[g] &&
+              s.prevDinoY == prevYs[g] && s.vy == vys[g] &&
+              s.onGround == bool(onGround[g]) &&
+              s.isCrouching == bool(crouching[g]) &&
+              s.currentState == states[g] && s.gameOver == bool(over[g]) &&
+              s.started == bool(running[g]) &&
+              s.currentRunFrame == runFrames[g] &&
+              s.currentDuckFrame == duckFrames[g] &&
+              s.currentBirdFrame == birdFrames[g] &&
+              s.animTimer == animTimers[g] && s.groundScroll == scrolls[g] &&
+              s.speed == speeds[g] && s.score == scores[g] &&
+              s.distanceTraveled == distances[g] &&
+              s.spawnTimer == spawnTimers[g] && s.isNight == bool(night[g]) &&
+              s.lastColorSwitch == lastColorSwitches[g] &&
+              s.seed() == seeds[g];
+  if (!same)
+    return false;
+
+  const GameState::Obstacles *pools[KIND_COUNT] = {&s.cactus, &s.birds,
+                                                   &s.clouds};
+  for (int k = 0; k < KIND_COUNT; ++k) {
+    const GameState::Obstacles &pool = *pools[k];
+    if (pool.size() != counts[k][g])
+      return false;
+    for (int i = 0; i < pool.size(); ++i) {
+      GameRect a = pool[i];
+      GameRect b = obstacle(Kind(k), g, i);
+      if (a.x != b.x || a.y != b.y || a.w != b.w || a.h != b.h)
+        return false;
+      if (k == CACTUS && pool.type(i) != types[slot(k, g, i)])
+        return false;
+    }
+  }
+  return true;
+}
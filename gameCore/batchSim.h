@@ -0,0 +1,108 @@
+#ifndef BATCHSIM_H
+#define BATCHSIM_H
+
+#include "gameState.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Many independent games stepped in lockstep, for bot training and
+// parameter sweeps. Game i behaves exactly like a GameState without
+// collision masks reset with the same seed and given the same inputs.
+//
+// State is kept as structure of arrays with one entry per game. The
+// arithmetic every game does on every step (moving obstacles, the dino's
+// vertical motion, the collision broad phase) runs on SIMD vectors of
+// games (see simd.h); the rare, branchy parts (input, spawning, culling,
+// animation, the exact collision test) run per game in scalar code that
+// mirrors GameState.
+class BatchSim {
+public:
+  // Live obstacles of each kind per game. The default config never has
+  // more than a handful on screen, see overflowed().
+  static const int SLOTS = 8;
+  enum Kind { CACTUS, BIRD, CLOUD, KIND_COUNT };
+
+  explicit BatchSim(int games, const GameConfig &config = GameConfig());
+
+  int size() const { return count; }
+  const GameConfig &config() const { return cfg; }
+  // SIMD instruction set the kernels were compiled for
+  static const char *isa();
+
+  // Same as GameState::reset(seed) for one game
+  void reset(int game, uint32_t seed);
+  // Begins the run without the opening jump (GameState::started = true)
+  void start(int game) { running[game] = true; }
+  // Advances every game by dt, inputs holds one entry per game. Games that
+  // are over do not change.
+  void step(const GameInput *inputs, float dt);
+
+  // GameEvent bits of the last step
+  unsigned events(int game) const { return lastEvents[game]; }
+  bool gameOver(int game) const { return over[game]; }
+  bool started(int game) const { return running[game]; }
+  int score(int game) const { return scores[game]; }
+  float dinoY(int game) const { return dinoYs[game]; }
+  float dinoHeight(int game) const { return dinoHs[game]; }
+  float dinoVy(int game) const { return vys[game]; }
+  bool isOnGround(int game) const { return onGround[game]; }
+  bool isCrouching(int game) const { return crouching[game]; }
+  float speed(int game) const { return speeds[game]; }
+  int obstacleCount(Kind kind, int game) const { return counts[kind][game]; }
+  // i-th live obstacle of a kind, oldest first
+  GameRect obstacle(Kind kind, int game, int i) const;
+
+  // More than SLOTS obstacles of one kind were live at once, so the oldest
+  // was dropped and the game no longer matches GameState
+  bool overflowed(int game) const { return overflow[game]; }
+
+  // True if game is in the same state as g, field by field
+  bool matches(int game, const GameState &g) const;
+
+private:
+  int slot(int kind, int game, int i) const;
+  int bounded(int game, int lo, int hi);
+  void spawn(int kind, int game, const GameRect &r, int type);
+  void retireOffscreen(int kind, int game);
+  void applyInput(int game, const GameInput &input);
+  void beginPhysics(int game, float dt);
+  void endPhysics(int game, float dt);
+  bool sweptHit(int game, int kind, int i) const;
+
+  void moveObstacles();
+  void moveDino();
+  void checkCollisions();
+
+  GameConfig cfg;
+  int count;
+  int stride; // games rounded up to the vector width
+
+  // per game, float arrays padded to stride
+  std::vector<std::mt19937> rngs;
+  std::vector<uint32_t> seeds;
+  std::vector<float> dinoYs, dinoHs, prevYs, vys;
+  std::vector<float> stepDxs, stepDys;
+  std::vector<float> speeds, distances, spawnTimers, animTimers, scrolls;
+  std::vector<int> scores, lastColorSwitches;
+  std::vector<int> runFrames, duckFrames, birdFrames;
+  std::vector<GameState::DinoState> states;
+  std::vector<unsigned> lastEvents;
+  std::vector<uint8_t> onGround, crouching, over, running, night, overflow;
+  std::vector<uint8_t> jumpPhases; // GameState::jumpPhase
+
+  // kernel inputs and outputs, 1.f for true
+  std::vector<float> inAir;   // moving vertically this step
+  std::vector<float> airDts;  // time in the air this step, see airTime()
+  std::vector<float> landed;  // touched the ground this step
+  std::vector<float> checked; // collisions tested this step
+
+  // obstacles: [kind][slot * stride + game], free slots sit far below the
+  // playfield so the broad phase never picks them
+  std::vector<float> xs[KIND_COUNT], ys[KIND_COUNT], ws[KIND_COUNT],
+      hs[KIND_COUNT];
+  std::vector<int> types; // cactus sprites, same layout
+  std::vector<int> heads[KIND_COUNT], counts[KIND_COUNT];
+};
+
+#endif // BATCHSIM_H
@@ -0,0 +1,61 @@
+#include "collisionMask.h"
+#include <algorithm>
+
+CollisionMask::CollisionMask(int width, int height)
+    : w(std::max(0, width)), h(std::max(0, height)), stride((w + 63) / 64),
+      bits(size_t(stride) * h, 0) {}
+
+void CollisionMask::set(int x, int y) {
+  if (x < 0 || y < 0 || x >= w || y >= h)
+    return;
+  bits[size_t(y) * stride + x / 64] |= uint64_t(1) << (x % 64);
+}
+
+bool CollisionMask::test(int x, int y) const {
+  if (x < 0 || y < 0 || x >= w || y >= h)
+    return false;
+  return (bits[size_t(y) * stride + x / 64] >> (x % 64)) & 1;
+}
+
+void CollisionMask::setOffset(int offsetX, int offsetY) {
+  dx = offsetX;
+  dy = offsetY;
+}
+
+uint64_t CollisionMask::bitsAt(int y, int x) const {
+  const uint64_t *row = bits.data() + size_t(y) * stride;
+  // floor division, x may be negative
+  int word = x >= 0 ? x / 64 : -((-x + 63) / 64);
+  int shift = x - word * 64;
+
+  uint64_t lo = (word >= 0 && word < stride) ? row[word] : 0;
+  uint64_t hi = (word + 1 >= 0 && word + 1 < stride) ? row[word + 1] : 0;
+  if (shift == 0)
+    return lo;
+  return (lo >> shift) | (hi << (64 - shift));
+}
+
+bool CollisionMask::overlaps(const CollisionMask &a, int ax, int ay,
+                             const CollisionMask &b, int bx, int by) {
+  // broad phase: bounding boxes
+  int x0 = std::max(ax, bx);
+  int x1 = std::min(ax + a.w, bx + b.w);
+  int y0 = std::max(ay, by);
+  int y1 = std::min(ay + a.h, by + b.h);
+  if (x0 >= x1 || y0 >= y1)
+    return false;
+
+  // narrow phase: words of a covering [x0, x1) against b shifted into a's
+  // coordinates. Bits past either mask's width are zero, so whole words can
+  // be compared.
+  int firstWord = (x0 - ax) / 64;
+  int lastWord = (x1 - ax - 1) / 64;
+  for (int y = y0; y < y1; ++y) {
+    const uint64_t *rowA = a.bits.data() + size_t(y - ay) * a.stride;
+    for (int word = firstWord; word <= lastWord; ++word) {
+      if (rowA[word] & b.bitsAt(y - by, word * 64 + ax - bx))
+        return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,45 @@
+#ifndef COLLISIONMASK_H
+#define COLLISIONMASK_H
+
+#include <cstdint>
+#include <vector>
+
+// 1 bit per pixel mask of a sprite frame, set where the sprite is opaque.
+// Rows are packed into 64-bit words (pixel x is bit x % 64 of word x / 64)
+// so two masks are tested against each other a word at a time.
+class CollisionMask {
+public:
+  CollisionMask() = default;
+  CollisionMask(int width, int height);
+
+  bool isNull() const { return w == 0 || h == 0; }
+  int width() const { return w; }
+  int height() const { return h; }
+
+  void set(int x, int y);
+  bool test(int x, int y) const;
+
+  // Where the sprite is drawn relative to the top-left of its object's box
+  void setOffset(int dx, int dy);
+  int offsetX() const { return dx; }
+  int offsetY() const { return dy; }
+
+  // True if a drawn at (ax, ay) and b drawn at (bx, by) share an opaque
+  // pixel. The bounding boxes are compared first, then only the rows and
+  // words where they overlap.
+  static bool overlaps(const CollisionMask &a, int ax, int ay,
+                       const CollisionMask &b, int bx, int by);
+
+private:
+  // 64 pixels of row y starting at x, which may lie outside the mask
+  uint64_t bitsAt(int y, int x) const;
+
+  int w = 0;
+  int h = 0;
+  int stride = 0; // words per row
+  int dx = 0;
+  int dy = 0;
+  std::vector<uint64_t> bits;
+};
+
+#endif // COLLISIONMASK_H
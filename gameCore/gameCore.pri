@@ -0,0 +1,33 @@
+# Headless game rules, shared by the game and the gameCore library
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/batchSim.cpp \
+    $$PWD/collisionMask.cpp \
+    $$PWD/gameState.cpp \
+    $$PWD/inputLatch.cpp \
+    $$PWD/latencyStats.cpp \
+    $$PWD/replay.cpp \
+    $$PWD/trace.cpp
+
+HEADERS += \
+    $$PWD/batchSim.h \
+    $$PWD/collisionMask.h \
+    $$PWD/gameRect.h \
+    $$PWD/gameState.h \
+    $$PWD/inputLatch.h \
+    $$PWD/latencyStats.h \
+    $$PWD/obstaclePool.h \
+    $$PWD/renderSnapshot.h \
+    $$PWD/replay.h \
+    $$PWD/simd.h \
+    $$PWD/spscQueue.h \
+    $$PWD/trace.h \
+    $$PWD/tripleBuffer.h
+
+# no fused multiply-add contraction: replays and BatchSim must give the same
+# floats as GameState on every target
+gcc|clang: QMAKE_CXXFLAGS += -ffp-contract=off
+
+# per-stage trace spans, see trace.h
+tracing: DEFINES += TRACING
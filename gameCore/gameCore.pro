@@ -0,0 +1,9 @@
+# Game rules as a static library without Qt, for headless runs on build
+# machines (balance tests, regression checks)
+TEMPLATE = lib
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+TARGET = gameCore
+
+include(gameCore.pri)
@@ -0,0 +1,68 @@
+#ifndef GAMERECT_H
+#define GAMERECT_H
+
+#include <algorithm>
+#include <cmath>
+
+// Axis aligned box in screen pixels, y grows downwards
+struct GameRect {
+  float x = 0.f;
+  float y = 0.f;
+  float w = 0.f;
+  float h = 0.f;
+
+  float right() const { return x + w; }
+  float bottom() const { return y + h; }
+  void moveBottom(float b) { y = b - h; }
+  // Area of the intersection, 0 if the boxes do not overlap
+  float overlapArea(const GameRect &o) const {
+    float ow = std::min(right(), o.right()) - std::max(x, o.x);
+    float oh = std::min(bottom(), o.bottom()) - std::max(y, o.y);
+    if (ow <= 0.f || oh <= 0.f)
+      return 0.f;
+    return ow * oh;
+  }
+};
+
+// Part [enter, exit] of a move by v where [a0, a1) overlaps [b0, b1)
+inline void sweepSlab(float a0, float a1, float v, float b0, float b1,
+                      float &enter, float &exit) {
+  if (v == 0.f) {
+    bool overlap = a1 > b0 && a0 < b1;
+    enter = overlap ? 0.f : 1.f;
+    exit = overlap ? 1.f : 0.f;
+    return;
+  }
+  float t0 = (b0 - a1) / v;
+  float t1 = (b1 - a0) / v;
+  enter = std::min(t0, t1);
+  exit = std::max(t0, t1);
+}
+
+// Swept AABB: a moves by (vx, vy) over one step past the static b. The
+// boxes give the part of the step where the two can touch; hit(t) is asked
+// at times in that part at most one pixel of travel apart, until it says
+// true.
+template <typename Hit>
+bool sweepBoxes(const GameRect &a, float vx, float vy, const GameRect &b,
+                Hit hit) {
+  float enterX, exitX, enterY, exitY;
+  sweepSlab(a.x, a.right(), vx, b.x, b.right(), enterX, exitX);
+  sweepSlab(a.y, a.bottom(), vy, b.y, b.bottom(), enterY, exitY);
+  float enter = std::max({enterX, enterY, 0.f});
+  float exit = std::min({exitX, exitY, 1.f});
+  if (enter >= exit)
+    return false;
+
+  const int maxSamples = 256;
+  float travel = (exit - enter) * std::max(std::fabs(vx), std::fabs(vy));
+  int samples = std::min(maxSamples, int(std::ceil(travel)) + 1);
+  for (int i = 0; i < samples; ++i) {
+    float t = samples == 1 ? exit : enter + (exit - enter) * i / (samples - 1);
+    if (hit(t))
+      return true;
+  }
+  return false;
+}
+
+#endif // GAMERECT_H
@@ -0,0 +1,371 @@
+#include "gameState.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+GameState::GameState(const GameConfig &config) : cfg(config) { reset(); }
+
+void GameState::reset() { reset(std::random_device{}()); }
+
+void GameState::reset(uint32_t seed) {
+  runSeed = seed;
+  rng.seed(seed);
+  dino = GameRect{40.f, float(cfg.groundY - cfg.dinoH), float(cfg.dinoW),
+                  float(cfg.dinoH)};
+  prevDinoY = dino.y;
+  stepDx = stepDy = 0.f;
+  jumpPhase = 0;
+  vy = 0.f;
+  onGround = true;
+  isCrouching = false;
+  currentState = START;
+  gameOver = false;
+  started = false;
+  currentRunFrame = currentDuckFrame = 0;
+  currentBirdFrame = 0;
+  animTimer = 0.f;
+  cactus.clear();
+  birds.clear();
+  clouds.clear();
+  groundScroll = 0.f;
+  speed = cfg.baseSpeed;
+  score = 0;
+  distanceTraveled = 0.f;
+  spawnTimer = 0.f;
+  isNight = false;
+  lastColorSwitch = 0;
+}
+
+// std::uniform_int_distribution differs between standard libraries, this
+// gives the same sequence everywhere so replays carry across builds
+int GameState::bounded(int lo, int hi) {
+  uint64_t r = uint32_t(rng());
+  return lo + int((r * uint64_t(hi - lo)) >> 32);
+}
+
+unsigned GameState::step(const GameInput &input, float dt) {
+  unsigned events = EVENT_NONE;
+  applyInput(input, events);
+  if (gameOver)
+    return events;
+
+  {
+    TRACE_SCOPE("updatePhysics");
+    updatePhysics(dt, events);
+  }
+  TRACE_SCOPE("checkCollision");
+  if (started && checkCollision()) {
+    gameOver = true;
+    currentState = DEAD;
+    events |= EVENT_HIT;
+  }
+  return events;
+}
+
+void GameState::applyInput(const GameInput &input, unsigned &events) {
+  if (input.jumpPressed && !gameOver) {
+    if (!started) {
+      started = true;
+    }
+    if (onGround) {
+      onGround = false;
+      vy = cfg.jumpV;
+      jumpPhase = input.jumpPhase;
+      events |= EVENT_JUMP;
+      currentState = JUMP;
+
+      float oldBottom = dino.bottom();
+      dino.h = cfg.dinoH;
+      dino.moveBottom(oldBottom);
+    }
+  }
+
+  if (input.duckPressed && !gameOver) {
+    if (!isCrouching) {
+      isCrouching = true;
+    }
+    // accelerate falling to ground
+    if (!onGround)
+      vy += cfg.fastFallV;
+  }
+
+  if (input.duckReleased && isCrouching) {
+    isCrouching = false;
+    // Return to normal height
+    float oldBottom = dino.bottom();
+    dino.h = cfg.dinoH;
+    dino.moveBottom(oldBottom);
+  }
+}
+
+void GameState::spawnCactus() {
+  // Randomly choose between large and small cactus
+  bool isLarge = bounded(0, 2) == 0;
+  int spriteIndex = bounded(0, 3);
+  int type = isLarge ? spriteIndex : spriteIndex + 3; // 0-2 large, 3-5 small
+
+  float w = cfg.cactusW[type];
+  float h = cfg.cactusH[type];
+  float x = cfg.width + bounded(0, 40);
+  float y = cfg.groundY - h;
+  cactus.spawn(GameRect{x, y, w, h}, type);
+}
+
+void GameState::spawnBird() {
+  float x = cfg.width + bounded(0, 60);
+
+  int yLevel = bounded(0, 3);
+  float y;
+  if (yLevel == 0)
+    y = cfg.groundY - 60;
+  else if (yLevel == 1)
+    y = cfg.groundY - 90;
+  else
+    y = cfg.groundY - 120;
+  birds.spawn(GameRect{x, y, float(cfg.birdW), float(cfg.birdH)});
+}
+
+void GameState::spawnCloud() {
+  float x = cfg.width + bounded(0, 50);
+
+  // clouds appear at random heights above the ground
+  float y = bounded(20, 120);
+  clouds.spawn(GameRect{x, y, float(cfg.cloudW), float(cfg.cloudH)});
+}
+
+void GameState::updateDinoState() {
+  if (currentState == JUMP)
+    return;
+
+  if (onGround && isCrouching) {
+    currentState = DUCK;
+  } else {
+    currentState = RUN;
+  }
+}
+
+void GameState::updateAnimation(float dt) {
+  animTimer += dt;
+  if (animTimer < cfg.animFrameDuration)
+    return;
+  animTimer -= cfg.animFrameDuration;
+
+  if (currentState == RUN) {
+    currentRunFrame = (currentRunFrame + 1) % cfg.runFrameCount;
+  } else {
+    currentDuckFrame = (currentDuckFrame + 1) % cfg.duckFrameCount;
+  }
+
+  // Update bird animation
+  currentBirdFrame = (currentBirdFrame + 1) % 2;
+}
+
+void GameState::updatePhysics(float dt, unsigned &events) {
+  if (!started) {
+    return;
+  }
+
+  // remove obstacles that went off screen during the previous step. They
+  // are kept for one step so checkCollision() still sweeps through them.
+  cactus.retireOffscreen();
+  birds.retireOffscreen();
+  clouds.retireOffscreen();
+
+  // background moves toward left
+  float dx = -speed * dt;
+  stepDx = dx;
+  cactus.moveBy(dx);
+  // move birds (faster than cactus)
+  birds.moveBy(dx * cfg.birdSpeedFactor);
+  // move clouds
+  clouds.moveBy(dx * cfg.cloudSpeedFactor);
+
+  // update distance traveled and calculate score
+  distanceTraveled += speed * dt;
+  int newScore = (int)(distanceTraveled / 10.0f);
+
+  // increase speed when score increases by 100
+  if (newScore / 100 > score / 100) {
+    speed = std::min(cfg.maxSpeed, speed + cfg.speedStep);
+    events |= EVENT_POINT;
+  }
+  score = newScore;
+
+  // dinosaur move vertically
+  prevDinoY = dino.y;
+  stepDy = 0.f;
+  if (!onGround) {
+    float air = airTime(dt, jumpPhase);
+    vy += cfg.gravity * air;
+    dino.y += vy * air;
+    if (dino.bottom() >= cfg.groundY) {
+      dino.moveBottom(cfg.groundY);
+      vy = 0.f;
+      onGround = true;
+
+      if (isCrouching) {
+        currentState = DUCK;
+      } else {
+        currentState = RUN;
+      }
+    }
+    stepDy = dino.y - prevDinoY;
+  }
+  jumpPhase = 0;
+
+  // dinosaur crouches
+  if (onGround && isCrouching) {
+    float oldBottom = dino.bottom();
+    dino.h = cfg.dinoDuckH;
+    dino.moveBottom(oldBottom);
+  }
+
+  updateDinoState();
+  updateAnimation(dt);
+
+  // Day/night cycle based on score milestones
+  int initial = 200;
+  if (score >= initial) {
+    int milestone = ((score - initial) / 200) + 1;
+    if (milestone != lastColorSwitch) {
+      lastColorSwitch = milestone;
+      isNight = !isNight;
+      events |= EVENT_DAY_NIGHT;
+    }
+  }
+
+  // create obstacles
+  spawnTimer -= dt;
+  if (spawnTimer <= 0.f) {
+    float obstacleType = bounded(0, 1000) / 1000.f;
+
+    bool isBird = (obstacleType >= 1.f - cfg.birdChance);
+
+    if (isBird) {
+      spawnBird();
+    } else {
+      spawnCactus();
+    }
+
+    // maybe spawn a cloud
+    float cloudChance = bounded(0, 1000) / 1000.f;
+    if (cloudChance < cfg.cloudChance) {
+      spawnCloud();
+    }
+
+    float r = bounded(0, 1000) / 1000.f;
+    float gap = cfg.spawnMin + r * (cfg.spawnMax - cfg.spawnMin);
+    // Adjust gap based on speed, and increase gap for birds since they move
+    // faster
+    float adjustedGap = gap - (speed - 180.f) / 600.f;
+    if (isBird) {
+      adjustedGap *= 1.3f;
+    }
+    spawnTimer = std::max(cfg.minGap, adjustedGap);
+  }
+
+  // ground scrolls with the obstacles
+  groundScroll += speed * dt;
+  if (groundScroll >= cfg.groundTileW)
+    groundScroll = std::fmod(groundScroll, (float)cfg.groundTileW);
+}
+
+void GameState::setDinoMasks(std::shared_ptr<const DinoMasks> masks) {
+  dinoMasks = std::move(masks);
+}
+
+void GameState::setObstacleMasks(std::shared_ptr<const ObstacleMasks> masks) {
+  obstacleMasks = std::move(masks);
+}
+
+const CollisionMask *GameState::currentDinoMask() const {
+  if (!dinoMasks)
+    return nullptr;
+  const DinoMasks &m = *dinoMasks;
+
+  const CollisionMask *mask = nullptr;
+  switch (currentState) {
+  case START:
+    mask = &m.start;
+    break;
+  case RUN:
+    if (!m.run.empty())
+      mask = &m.run[currentRunFrame % m.run.size()];
+    break;
+  case DUCK:
+    if (!m.duck.empty())
+      mask = &m.duck[currentDuckFrame % m.duck.size()];
+    break;
+  case JUMP:
+  case DEAD:
+    mask = &m.jump;
+    break;
+  }
+  return (mask && !mask->isNull()) ? mask : nullptr;
+}
+
+// Masks are placed where their sprites are drawn, at whole pixels
+bool GameState::hits(const GameRect &dinoBox, const CollisionMask *dinoMask,
+                     const GameRect &box, const CollisionMask *mask) const {
+  if (!dinoMask || !mask)
+    return dinoBox.overlapArea(box) > cfg.minOverlap;
+
+  auto px = [](float v) { return int(std::floor(v + 0.5f)); };
+  return CollisionMask::overlaps(
+      *dinoMask, px(dinoBox.x) + dinoMask->offsetX(),
+      px(dinoBox.y) + dinoMask->offsetY(), *mask, px(box.x) + mask->offsetX(),
+      px(box.y) + mask->offsetY());
+}
+
+namespace {
+
+// Area the collision test looks at: the drawn sprite if there is a mask
+GameRect extent(const GameRect &box, const CollisionMask *mask) {
+  if (!mask)
+    return box;
+  return GameRect{box.x + mask->offsetX(), box.y + mask->offsetY(),
+                  float(mask->width()), float(mask->height())};
+}
+
+} // namespace
+
+// In the frame of the obstacle (where it is now) the dino moves from its
+// previous position by (-boxDx, stepDy) over the step
+bool GameState::sweptHit(const CollisionMask *dinoMask, const GameRect &box,
+                         float boxDx, const CollisionMask *mask) const {
+  const float vx = -boxDx;
+  const float vy = stepDy;
+  GameRect start = dino;
+  start.x += boxDx;
+  start.y -= stepDy;
+
+  return sweepBoxes(extent(start, dinoMask), vx, vy, extent(box, mask),
+                    [&](float t) {
+                      GameRect d = start;
+                      d.x += vx * t;
+                      d.y += vy * t;
+                      return hits(d, dinoMask, box, mask);
+                    });
+}
+
+bool GameState::checkCollision() const {
+  const CollisionMask *dinoMask = currentDinoMask();
+  const ObstacleMasks *m = obstacleMasks.get();
+
+  for (int i = 0; i < cactus.size(); ++i) {
+    const CollisionMask *mask = m ? &m->cactus[cactus.type(i)] : nullptr;
+    if (mask && mask->isNull())
+      mask = nullptr;
+    if (sweptHit(dinoMask, cactus[i], stepDx, mask))
+      return true;
+  }
+  const CollisionMask *birdMask = m ? &m->bird[currentBirdFrame % 2] : nullptr;
+  if (birdMask && birdMask->isNull())
+    birdMask = nullptr;
+  const float birdDx = stepDx * cfg.birdSpeedFactor;
+  for (const auto &b : birds) {
+    if (sweptHit(dinoMask, b, birdDx, birdMask))
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,185 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include "collisionMask.h"
+#include "gameRect.h"
+#include "obstaclePool.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Game rules without any Qt dependency, so they can run headless (balance
+// tests, tools) as well as behind the dinosaur widget.
+
+// Key edges since the previous step
+struct GameInput {
+  bool jumpPressed = false;
+  bool duckPressed = false;
+  bool duckReleased = false;
+  // when in the step the jump key went down, in 1/256 of the step
+  uint8_t jumpPhase = 0;
+};
+
+// Time in the air during a step of dt with a jump taken at jumpPhase, so a
+// jump lands where it would have if steps were infinitely short
+inline float airTime(float dt, uint8_t jumpPhase) {
+  return dt - dt * (jumpPhase / 256.f);
+}
+
+// Bits returned by GameState::step()
+enum GameEvent : unsigned {
+  EVENT_NONE = 0,
+  EVENT_JUMP = 1 << 0,
+  EVENT_POINT = 1 << 1, // score passed a multiple of 100
+  EVENT_HIT = 1 << 2,   // game over
+  EVENT_DAY_NIGHT = 1 << 3,
+};
+
+struct GameConfig {
+  // playfield
+  int width = 480;
+  int groundY = 200;
+
+  // speeds in pixels per second
+  float baseSpeed = 200.f;
+  float maxSpeed = 420.f;
+  float speedStep = 10.f; // added every 100 points
+  float birdSpeedFactor = 1.4f;
+  float cloudSpeedFactor = 1.5f;
+
+  // physics
+  float gravity = 2400.f;
+  float jumpV = -700.f;
+  float fastFallV = 300.f; // added to vy when ducking in the air
+
+  // spawning
+  float spawnMin = 1.0f;
+  float spawnMax = 1.8f;
+  float minGap = 0.9f;
+  float birdChance = 0.2f;
+  float cloudChance = 0.8f;
+
+  // collision, only used for objects without a pixel mask
+  float minOverlap = 125.f;
+
+  // sizes, matching the scaled sprites. Cactus types 0-2 are large, 3-5 small
+  int cactusW[6] = {17, 36, 37, 14, 23, 36};
+  int cactusH[6] = {35, 35, 35, 25, 25, 25};
+  int birdW = 28;
+  int birdH = 18;
+  int cloudW = 49;
+  int cloudH = 60;
+  int groundTileW = 1717;
+  int dinoW = 36;
+  int dinoH = 40;
+  int dinoDuckH = 20;
+
+  // animation
+  float animFrameDuration = 0.08f;
+  int runFrameCount = 2;
+  int duckFrameCount = 2;
+};
+
+// Pixel masks of the dinosaur frames of one skin
+struct DinoMasks {
+  CollisionMask start;
+  CollisionMask jump;
+  std::vector<CollisionMask> run;
+  std::vector<CollisionMask> duck;
+};
+
+// Pixel masks of the obstacle sprites, indexed like the sprites
+struct ObstacleMasks {
+  CollisionMask cactus[6];
+  CollisionMask bird[2]; // per wing frame
+};
+
+class GameState {
+public:
+  enum DinoState { RUN, DUCK, START, JUMP, DEAD };
+  // per kind of obstacle; far more than fit on screen at once
+  static constexpr int MAX_OBSTACLES = 64;
+  typedef ObstaclePool<MAX_OBSTACLES> Obstacles;
+
+  explicit GameState(const GameConfig &config = GameConfig());
+
+  // Starts a new run with a fresh random seed, or with the given one. A run
+  // is fully determined by its seed, the collision masks and the inputs of
+  // each step.
+  void reset();
+  void reset(uint32_t seed);
+  uint32_t seed() const { return runSeed; }
+  // Advances the game by dt seconds, returns GameEvent bits
+  unsigned step(const GameInput &input, float dt);
+  const GameConfig &config() const { return cfg; }
+
+  // Pixel masks used by checkCollision(). Without them (headless tools)
+  // hits are decided by box overlap against minOverlap.
+  void setDinoMasks(std::shared_ptr<const DinoMasks> masks);
+  void setObstacleMasks(std::shared_ptr<const ObstacleMasks> masks);
+
+  // Stages of step(), public for tools and benchmarks. checkCollision()
+  // sweeps the dino and obstacles from where they were before the last
+  // updatePhysics() to where they are now, so large steps cannot skip a hit.
+  void spawnCactus();
+  void spawnBird();
+  void spawnCloud();
+  void updatePhysics(float dt, unsigned &events);
+  bool checkCollision() const;
+
+  // dinosaur
+  GameRect dino;
+  float prevDinoY = 0.f; // dino.y before the last step
+  float vy = 0.f;
+  bool onGround = true;
+  bool isCrouching = false;
+  DinoState currentState = START;
+  bool gameOver = false;
+  bool started = false;
+
+  // animation
+  int currentRunFrame = 0;
+  int currentDuckFrame = 0;
+  int currentBirdFrame = 0;
+  float animTimer = 0.f;
+
+  // obstacles and scenery
+  Obstacles cactus; // type() is the cactus sprite
+  Obstacles birds;
+  Obstacles clouds;
+  float groundScroll = 0.f; // in [0, groundTileW)
+
+  // progress
+  float speed = 0.f;
+  int score = 0;
+  float distanceTraveled = 0.f;
+  float spawnTimer = 0.f;
+
+  // day / night cycle
+  bool isNight = false;
+  int lastColorSwitch = 0; // last score milestone that switched
+
+private:
+  void applyInput(const GameInput &input, unsigned &events);
+  void updateDinoState();
+  void updateAnimation(float dt);
+  int bounded(int lo, int hi); // uniform in [lo, hi)
+  const CollisionMask *currentDinoMask() const;
+  bool hits(const GameRect &dinoBox, const CollisionMask *dinoMask,
+            const GameRect &box, const CollisionMask *mask) const;
+  bool sweptHit(const CollisionMask *dinoMask, const GameRect &box,
+                float boxDx, const CollisionMask *mask) const;
+
+  GameConfig cfg;
+  // movement during the last updatePhysics(), for the swept collision test
+  float stepDx = 0.f; // of the cacti; birds move birdSpeedFactor times that
+  float stepDy = 0.f; // of the dino, from its velocity only
+  uint8_t jumpPhase = 0; // of a jump taken by this step's input
+  std::shared_ptr<const DinoMasks> dinoMasks;
+  std::shared_ptr<const ObstacleMasks> obstacleMasks;
+  uint32_t runSeed = 0;
+  std::mt19937 rng; // reseeded by reset()
+};
+
+#endif // GAMESTATE_H
@@ -0,0 +1,49 @@
+#include "inputLatch.h"
+#include <algorithm>
+
+void InputLatch::press(Button button, int64_t timeNs) {
+  add(button, true, timeNs);
+}
+
+void InputLatch::release(Button button, int64_t timeNs) {
+  add(button, false, timeNs);
+}
+
+void InputLatch::add(Button button, bool isDown, int64_t timeNs) {
+  down[button] = isDown;
+
+  // sources stamp independently, keep the queue in time order
+  auto at = std::upper_bound(
+      events.begin(), events.end(), timeNs,
+      [](int64_t t, const Event &e) { return t < e.timeNs; });
+  events.insert(at, Event{timeNs, button, isDown});
+}
+
+GameInput InputLatch::take(int64_t startNs, int64_t stepNs) {
+  GameInput input;
+  const int64_t endNs = startNs + stepNs;
+  const bool wasDucking = stepDown[DUCK];
+
+  size_t n = 0;
+  for (; n < events.size() && events[n].timeNs < endNs; ++n) {
+    const Event &e = events[n];
+    stepDown[e.button] = e.down;
+    if (!e.down)
+      continue;
+    if (e.button == JUMP && !input.jumpPressed) {
+      input.jumpPressed = true;
+      jumpNs = e.timeNs;
+      int64_t offset = std::max<int64_t>(0, e.timeNs - startNs);
+      input.jumpPhase = uint8_t(std::min<int64_t>(255, offset * 256 / stepNs));
+    } else if (e.button == DUCK) {
+      input.duckPressed = true;
+    }
+  }
+  events.erase(events.begin(), events.begin() + n);
+
+  // GameState applies a duck press before a release, so a release only
+  // goes through when the button ends the step up
+  input.duckReleased =
+      !stepDown[DUCK] && (wasDucking || input.duckPressed);
+  return input;
+}
@@ -0,0 +1,48 @@
+#ifndef INPUTLATCH_H
+#define INPUTLATCH_H
+
+#include "gameState.h"
+#include <cstdint>
+#include <vector>
+
+// Button presses and releases with their times, handed to the simulation
+// step that covers them. Events may come from several sources (keyboard,
+// GPIO) as long as all times are on one monotonic clock in nanoseconds.
+//
+// A jump is applied in the step it happened in, at its position within
+// that step (GameInput::jumpPhase), so where the dino lands does not depend
+// on when frames happen to be drawn. Events older than the step (delivered
+// late) count as happening at its start.
+class InputLatch {
+public:
+  enum Button { JUMP, DUCK, BUTTON_COUNT };
+
+  void press(Button button, int64_t timeNs);
+  void release(Button button, int64_t timeNs);
+  // Drops pending events, buttons held stay held
+  void clear() { events.clear(); }
+
+  // Latest state of a button, including events not yet taken
+  bool held(Button button) const { return down[button]; }
+
+  // Input of the step covering [startNs, startNs + stepNs), consuming the
+  // events before its end
+  GameInput take(int64_t startNs, int64_t stepNs);
+  // Time of the jump press in the last take(), if it had one
+  int64_t jumpTimeNs() const { return jumpNs; }
+
+private:
+  struct Event {
+    int64_t timeNs;
+    Button button;
+    bool down;
+  };
+  void add(Button button, bool down, int64_t timeNs);
+
+  std::vector<Event> events; // by time
+  bool down[BUTTON_COUNT] = {};
+  bool stepDown[BUTTON_COUNT] = {}; // as of the last take()
+  int64_t jumpNs = 0;
+};
+
+#endif // INPUTLATCH_H
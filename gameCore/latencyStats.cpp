@@ -0,0 +1,25 @@
+#include "latencyStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+int64_t LatencyStats::percentile(double p) const {
+  if (samples.empty())
+    return 0;
+  std::vector<int64_t> sorted(samples);
+  size_t rank = size_t(std::ceil(p / 100.0 * sorted.size()));
+  rank = std::min(sorted.size(), std::max<size_t>(1, rank));
+  std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.end());
+  return sorted[rank - 1];
+}
+
+std::string LatencyStats::report(const char *label) const {
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "%s: %zu samples, p50 %.2f ms p95 %.2f ms p99 %.2f ms "
+                "max %.2f ms",
+                label, samples.size(), percentile(50) / 1e6,
+                percentile(95) / 1e6, percentile(99) / 1e6,
+                percentile(100) / 1e6);
+  return line;
+}
@@ -0,0 +1,24 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Latency samples and their distribution
+class LatencyStats {
+public:
+  void add(int64_t ns) { samples.push_back(ns); }
+  void clear() { samples.clear(); }
+  size_t count() const { return samples.size(); }
+
+  // Nearest-rank percentile, p in (0, 100]. 0 without samples.
+  int64_t percentile(double p) const;
+  // "<label>: <n> samples, p50 <ms> p95 <ms> p99 <ms> max <ms>"
+  std::string report(const char *label) const;
+
+private:
+  std::vector<int64_t> samples;
+};
+
+#endif // LATENCYSTATS_H
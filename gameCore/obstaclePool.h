@@ -0,0 +1,85 @@
+#ifndef OBSTACLEPOOL_H
+#define OBSTACLEPOOL_H
+
+#include "gameRect.h"
+
+// Fixed-capacity ring of obstacles in structure-of-arrays layout. Obstacles
+// spawn at the right edge and all move at the same speed, so they leave the
+// screen in spawn order: spawning appends at the back and culling retires
+// from the front. Nothing here allocates.
+template <int Capacity> class ObstaclePool {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  class const_iterator {
+  public:
+    const_iterator(const ObstaclePool *pool, int i) : pool(pool), i(i) {}
+    GameRect operator*() const { return (*pool)[i]; }
+    const_iterator &operator++() {
+      ++i;
+      return *this;
+    }
+    bool operator!=(const const_iterator &o) const { return i != o.i; }
+
+  private:
+    const ObstaclePool *pool;
+    int i;
+  };
+
+  static constexpr int capacity() { return Capacity; }
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+  void clear() { head = count = 0; }
+
+  // Appends at the back. When full the oldest obstacle is dropped.
+  void spawn(const GameRect &r, int type = 0) {
+    int slot = (head + count) & MASK;
+    xs[slot] = r.x;
+    ys[slot] = r.y;
+    ws[slot] = r.w;
+    hs[slot] = r.h;
+    types[slot] = type;
+    bool full = count == Capacity;
+    head = (head + full) & MASK;
+    count += !full;
+  }
+
+  // Moves every slot, live or not, so the loop has no branches; free slots
+  // are overwritten on spawn.
+  void moveBy(float dx) {
+    for (int i = 0; i < Capacity; ++i)
+      xs[i] += dx;
+  }
+
+  // Retires obstacles whose right edge has passed the left screen edge
+  void retireOffscreen() {
+    while (count > 0 && xs[head] + ws[head] < 0.f) {
+      head = (head + 1) & MASK;
+      --count;
+    }
+  }
+
+  // i-th live obstacle, oldest first
+  GameRect operator[](int i) const {
+    int slot = (head + i) & MASK;
+    return GameRect{xs[slot], ys[slot], ws[slot], hs[slot]};
+  }
+  int type(int i) const { return types[(head + i) & MASK]; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+
+private:
+  static constexpr int MASK = Capacity - 1;
+
+  float xs[Capacity] = {};
+  float ys[Capacity] = {};
+  float ws[Capacity] = {};
+  float hs[Capacity] = {};
+  int types[Capacity] = {};
+  int head = 0;  // slot of the oldest obstacle
+  int count = 0; // live obstacles
+};
+
+#endif // OBSTACLEPOOL_H
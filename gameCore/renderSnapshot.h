@@ -0,0 +1,59 @@
+#ifndef RENDERSNAPSHOT_H
+#define RENDERSNAPSHOT_H
+
+#include "gameState.h"
+#include <cstdint>
+
+// What a frame needs of the game, copied out of GameState after a step so
+// the game can be drawn while the next steps run on another thread.
+struct RenderSnapshot {
+  // simulated time the state is at, on the monotonicNs() clock
+  int64_t timeNs = 0;
+
+  GameRect dino;
+  float prevDinoY = 0.f;
+  GameState::DinoState state = GameState::START;
+  int runFrame = 0;
+  int duckFrame = 0;
+  int birdFrame = 0;
+
+  GameState::Obstacles cactus;
+  GameState::Obstacles birds;
+  GameState::Obstacles clouds;
+  float groundScroll = 0.f;
+  float speed = 0.f;
+
+  int score = 0;
+  bool isNight = false;
+  bool started = false;
+  bool gameOver = false;
+
+  // Running counts of step events since the run started, so a reader that
+  // skips snapshots still sees every event. The times are of the latest
+  // jump: its press and the step that applied it.
+  uint32_t jumps = 0;
+  uint32_t points = 0;
+  int64_t jumpPressNs = 0;
+  int64_t jumpStepNs = 0;
+
+  // Copies the state of g, leaving the time and event counts alone
+  void capture(const GameState &g) {
+    dino = g.dino;
+    prevDinoY = g.prevDinoY;
+    state = g.currentState;
+    runFrame = g.currentRunFrame;
+    duckFrame = g.currentDuckFrame;
+    birdFrame = g.currentBirdFrame;
+    cactus = g.cactus;
+    birds = g.birds;
+    clouds = g.clouds;
+    groundScroll = g.groundScroll;
+    speed = g.speed;
+    score = g.score;
+    isNight = g.isNight;
+    started = g.started;
+    gameOver = g.gameOver;
+  }
+};
+
+#endif // RENDERSNAPSHOT_H
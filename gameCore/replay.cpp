@@ -0,0 +1,160 @@
+#include "replay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[4] = {'D', 'R', 'P', 'L'};
+const uint8_t VERSION = 2;
+const int KEY_BITS = 3;
+
+void putVarint(std::vector<uint8_t> &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(uint8_t(v) | 0x80);
+    v >>= 7;
+  }
+  out.push_back(uint8_t(v));
+}
+
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+  v = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    v |= uint64_t(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+uint8_t keysOf(const GameInput &input) {
+  return (input.jumpPressed ? Replay::KEY_JUMP : 0) |
+         (input.duckPressed ? Replay::KEY_DUCK : 0) |
+         (input.duckReleased ? Replay::KEY_DUCK_RELEASE : 0);
+}
+
+} // namespace
+
+Replay::Replay(int skin, uint32_t seed) : skinIndex(skin), runSeed(seed) {}
+
+void Replay::record(uint32_t step, const GameInput &input) {
+  uint8_t keys = keysOf(input);
+  if (!keys)
+    return;
+  if (recs.empty() || recs.back().step != step)
+    recs.push_back(Record{step, 0, 0});
+  Record &r = recs.back();
+  if (input.jumpPressed && !(r.keys & KEY_JUMP))
+    r.jumpPhase = input.jumpPhase;
+  r.keys |= keys;
+  endStep = std::max(endStep, step + 1);
+}
+
+void Replay::finish(uint32_t step) { endStep = std::max(endStep, step); }
+
+std::vector<uint8_t> Replay::encode() const {
+  std::vector<uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+  out.push_back(VERSION);
+  putVarint(out, uint32_t(skinIndex));
+  putVarint(out, runSeed);
+
+  uint32_t last = 0;
+  for (const Record &r : recs) {
+    putVarint(out, (uint64_t(r.step - last) << KEY_BITS) | r.keys);
+    if (r.keys & KEY_JUMP)
+      out.push_back(r.jumpPhase);
+    last = r.step;
+  }
+  putVarint(out, uint64_t(endStep - last) << KEY_BITS);
+  return out;
+}
+
+bool Replay::decode(const uint8_t *data, size_t size) {
+  const uint8_t *p = data;
+  const uint8_t *end = data + size;
+  if (size < sizeof(MAGIC) + 1 || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0)
+    return false;
+  uint8_t version = p[sizeof(MAGIC)];
+  if (version < 1 || version > VERSION)
+    return false;
+  p += sizeof(MAGIC) + 1;
+
+  uint64_t skin, seed;
+  if (!getVarint(p, end, skin) || !getVarint(p, end, seed))
+    return false;
+
+  std::vector<Record> decoded;
+  uint64_t step = 0;
+  for (;;) {
+    uint64_t v;
+    if (!getVarint(p, end, v))
+      return false;
+    step += v >> KEY_BITS;
+    if (step > UINT32_MAX)
+      return false;
+    uint8_t keys = v & ((1 << KEY_BITS) - 1);
+    if (!keys)
+      break;
+    uint8_t phase = 0;
+    if (version >= 2 && (keys & KEY_JUMP)) {
+      if (p == end)
+        return false;
+      phase = *p++;
+    }
+    decoded.push_back(Record{uint32_t(step), keys, phase});
+  }
+
+  skinIndex = int(skin);
+  runSeed = uint32_t(seed);
+  endStep = uint32_t(step);
+  recs.swap(decoded);
+  return true;
+}
+
+bool Replay::save(const std::string &path) const {
+  FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f)
+    return false;
+  std::vector<uint8_t> bytes = encode();
+  bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+bool Replay::load(const std::string &path) {
+  FILE *f = std::fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  std::vector<uint8_t> bytes;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+    bytes.insert(bytes.end(), buf, buf + n);
+  std::fclose(f);
+  return decode(bytes.data(), bytes.size());
+}
+
+GameInput ReplayCursor::next() {
+  GameInput input;
+  if (replay) {
+    const std::vector<Replay::Record> &recs = replay->records();
+    if (index < recs.size() && recs[index].step == current) {
+      const Replay::Record &r = recs[index++];
+      uint8_t keys = r.keys;
+      input.jumpPressed = keys & Replay::KEY_JUMP;
+      input.jumpPhase = r.jumpPhase;
+      input.duckPressed = keys & Replay::KEY_DUCK;
+      input.duckReleased = keys & Replay::KEY_DUCK_RELEASE;
+    }
+  }
+  ++current;
+  return input;
+}
+
+uint32_t runReplay(GameState &game, const Replay &replay, float dt) {
+  game.reset(replay.seed());
+  ReplayCursor cursor(&replay);
+  while (!cursor.atEnd() && !game.gameOver)
+    game.step(cursor.next(), dt);
+  return cursor.step();
+}
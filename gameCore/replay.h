@@ -0,0 +1,86 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "gameState.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Inputs of one run. Given the same skin (its collision masks) and seed, the
+// game replays exactly when the same inputs are applied at the same fixed
+// steps.
+//
+// File layout, varints are unsigned LEB128:
+//   "DRPL"   magic
+//   u8       version (2)
+//   varint   skin
+//   varint   seed
+//   varint   records, each (steps since the previous record << 3) | keys
+//            with keys a mix of Key bits, followed by a u8 jump phase if
+//            keys has KEY_JUMP. The last record has keys 0 and marks the
+//            end of the run.
+// Version 1 files have no jump phases and load with phase 0.
+class Replay {
+public:
+  enum Key : uint8_t {
+    KEY_JUMP = 1 << 0,
+    KEY_DUCK = 1 << 1,
+    KEY_DUCK_RELEASE = 1 << 2,
+  };
+
+  struct Record {
+    uint32_t step;
+    uint8_t keys;
+    uint8_t jumpPhase; // GameInput::jumpPhase
+  };
+
+  Replay() = default;
+  Replay(int skin, uint32_t seed);
+
+  int skin() const { return skinIndex; }
+  uint32_t seed() const { return runSeed; }
+  // Number of steps in the run
+  uint32_t length() const { return endStep; }
+  const std::vector<Record> &records() const { return recs; }
+
+  // Adds the input applied at `step`. Steps must not decrease.
+  void record(uint32_t step, const GameInput &input);
+  // The run ended after `step` steps
+  void finish(uint32_t step);
+
+  std::vector<uint8_t> encode() const;
+  bool decode(const uint8_t *data, size_t size);
+  bool save(const std::string &path) const;
+  bool load(const std::string &path);
+
+private:
+  int skinIndex = 0;
+  uint32_t runSeed = 0;
+  uint32_t endStep = 0;
+  std::vector<Record> recs;
+};
+
+// Hands out the input of each step of a replay in order
+class ReplayCursor {
+public:
+  ReplayCursor() = default;
+  explicit ReplayCursor(const Replay *replay) : replay(replay) {}
+
+  // Input of the current step, then moves to the next step
+  GameInput next();
+  uint32_t step() const { return current; }
+  bool atEnd() const { return !replay || current >= replay->length(); }
+
+private:
+  const Replay *replay = nullptr;
+  uint32_t current = 0;
+  size_t index = 0;
+};
+
+// Plays a replay on game as fast as possible: reset with the replay's seed,
+// then steps of dt until the run ends or the game is over. Returns the
+// number of steps run.
+uint32_t runReplay(GameState &game, const Replay &replay, float dt);
+
+#endif // REPLAY_H
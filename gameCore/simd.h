@@ -0,0 +1,119 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Small float vector wrapper for the batch simulation. Uses AVX, SSE2 or
+// NEON, whichever the compiler targets (e.g. -mavx, -mfpu=neon), and plain
+// floats otherwise. Only what the kernels need is here.
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace simd {
+
+#if defined(__AVX__)
+
+const int WIDTH = 8;
+const char *const NAME = "AVX";
+typedef __m256 vf;
+typedef __m256 vm; // lane mask
+
+inline vf load(const float *p) { return _mm256_loadu_ps(p); }
+inline void store(float *p, vf v) { _mm256_storeu_ps(p, v); }
+inline vf set1(float f) { return _mm256_set1_ps(f); }
+inline vf add(vf a, vf b) { return _mm256_add_ps(a, b); }
+inline vf sub(vf a, vf b) { return _mm256_sub_ps(a, b); }
+inline vf mul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+inline vf min(vf a, vf b) { return _mm256_min_ps(a, b); }
+inline vf max(vf a, vf b) { return _mm256_max_ps(a, b); }
+inline vm lt(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline vm ge(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline vm gt(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline vm both(vm a, vm b) { return _mm256_and_ps(a, b); }
+// m ? a : b per lane
+inline vf select(vm m, vf a, vf b) { return _mm256_blendv_ps(b, a, m); }
+// bit i set when lane i of m is set
+inline int bits(vm m) { return _mm256_movemask_ps(m); }
+
+#elif defined(__SSE2__)
+
+const int WIDTH = 4;
+const char *const NAME = "SSE2";
+typedef __m128 vf;
+typedef __m128 vm;
+
+inline vf load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, vf v) { _mm_storeu_ps(p, v); }
+inline vf set1(float f) { return _mm_set1_ps(f); }
+inline vf add(vf a, vf b) { return _mm_add_ps(a, b); }
+inline vf sub(vf a, vf b) { return _mm_sub_ps(a, b); }
+inline vf mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+inline vf min(vf a, vf b) { return _mm_min_ps(a, b); }
+inline vf max(vf a, vf b) { return _mm_max_ps(a, b); }
+inline vm lt(vf a, vf b) { return _mm_cmplt_ps(a, b); }
+inline vm ge(vf a, vf b) { return _mm_cmpge_ps(a, b); }
+inline vm gt(vf a, vf b) { return _mm_cmpgt_ps(a, b); }
+inline vm both(vm a, vm b) { return _mm_and_ps(a, b); }
+inline vf select(vm m, vf a, vf b) {
+  return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+inline int bits(vm m) { return _mm_movemask_ps(m); }
+
+#elif defined(__ARM_NEON)
+
+const int WIDTH = 4;
+const char *const NAME = "NEON";
+typedef float32x4_t vf;
+typedef uint32x4_t vm;
+
+inline vf load(const float *p) { return vld1q_f32(p); }
+inline void store(float *p, vf v) { vst1q_f32(p, v); }
+inline vf set1(float f) { return vdupq_n_f32(f); }
+inline vf add(vf a, vf b) { return vaddq_f32(a, b); }
+inline vf sub(vf a, vf b) { return vsubq_f32(a, b); }
+inline vf mul(vf a, vf b) { return vmulq_f32(a, b); }
+inline vf min(vf a, vf b) { return vminq_f32(a, b); }
+inline vf max(vf a, vf b) { return vmaxq_f32(a, b); }
+inline vm lt(vf a, vf b) { return vcltq_f32(a, b); }
+inline vm ge(vf a, vf b) { return vcgeq_f32(a, b); }
+inline vm gt(vf a, vf b) { return vcgtq_f32(a, b); }
+inline vm both(vm a, vm b) { return vandq_u32(a, b); }
+inline vf select(vm m, vf a, vf b) { return vbslq_f32(m, a, b); }
+// ARMv7 has no across-vector add, fold pairwise
+inline int bits(vm m) {
+  const int32x4_t shifts = {0, 1, 2, 3};
+  uint32x4_t b = vshlq_u32(vshrq_n_u32(m, 31), shifts);
+  uint32x2_t s = vadd_u32(vget_low_u32(b), vget_high_u32(b));
+  s = vpadd_u32(s, s);
+  return int(vget_lane_u32(s, 0));
+}
+
+#else
+
+const int WIDTH = 1;
+const char *const NAME = "scalar";
+typedef float vf;
+typedef bool vm;
+
+inline vf load(const float *p) { return *p; }
+inline void store(float *p, vf v) { *p = v; }
+inline vf set1(float f) { return f; }
+inline vf add(vf a, vf b) { return a + b; }
+inline vf sub(vf a, vf b) { return a - b; }
+inline vf mul(vf a, vf b) { return a * b; }
+inline vf min(vf a, vf b) { return a < b ? a : b; }
+inline vf max(vf a, vf b) { return a > b ? a : b; }
+inline vm lt(vf a, vf b) { return a < b; }
+inline vm ge(vf a, vf b) { return a >= b; }
+inline vm gt(vf a, vf b) { return a > b; }
+inline vm both(vm a, vm b) { return a && b; }
+inline vf select(vm m, vf a, vf b) { return m ? a : b; }
+inline int bits(vm m) { return m ? 1 : 0; }
+
+#endif
+
+} // namespace simd
+
+#endif // SIMD_H
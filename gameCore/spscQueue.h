@@ -0,0 +1,44 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. push() and pop() never block or allocate, so the producer can be
+// a real-time thread.
+template <typename T, int Capacity> class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  // Producer side. Returns false, dropping v, when the queue is full.
+  bool push(const T &v) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == size_t(Capacity))
+      return false;
+    items[h & MASK] = v;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when the queue is empty.
+  bool pop(T &v) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+      return false;
+    v = items[t & MASK];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static const size_t MASK = Capacity - 1;
+
+  // on separate cache lines, each is written by one side only
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+  T items[Capacity];
+};
+
+#endif // SPSCQUEUE_H
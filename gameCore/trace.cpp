@@ -0,0 +1,125 @@
+#include "trace.h"
+
+#ifdef TRACING
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const uint64_t RING_SIZE = 1 << 15; // spans per thread, power of two
+// spans this close to being overwritten are skipped by a live flush
+const uint64_t RING_MARGIN = 256;
+
+struct Span {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+};
+
+// Written only by its own thread; head is published after the span so a
+// flush from another thread sees complete spans.
+struct Ring {
+  Span spans[RING_SIZE];
+  std::atomic<uint64_t> head{0};
+  unsigned tid = 0;
+};
+
+std::mutex ringsMutex; // ring registration and flush only
+std::vector<Ring *> rings;
+unsigned nextTid = 1;
+
+std::string outputPath;
+uint64_t startTime = 0;
+int signalPipe[2] = {-1, -1};
+
+// Rings are never freed, so spans of finished threads can still be flushed
+Ring *threadRing() {
+  thread_local Ring *ring = [] {
+    Ring *r = new Ring;
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    r->tid = nextTid++;
+    rings.push_back(r);
+    return r;
+  }();
+  return ring;
+}
+
+void onSignal(int) {
+  char c = 0;
+  // write() is async-signal-safe, the flush runs on the trace thread
+  ssize_t ignored = write(signalPipe[1], &c, 1);
+  (void)ignored;
+}
+
+} // namespace
+
+std::atomic<bool> trace::detail::active{false};
+
+void trace::init() {
+  const char *path = std::getenv("DINO_TRACE");
+  if (!path || !*path || detail::active)
+    return;
+
+  outputPath = path;
+  startTime = now();
+
+  std::atexit([] { flush(); });
+  if (pipe(signalPipe) == 0) {
+    std::signal(SIGUSR1, onSignal);
+    std::thread([] {
+      char c;
+      while (read(signalPipe[0], &c, 1) == 1)
+        flush();
+    }).detach();
+  }
+
+  detail::active = true;
+}
+
+void trace::record(const char *name, uint64_t startNs, uint64_t endNs) {
+  Ring *r = threadRing();
+  uint64_t h = r->head.load(std::memory_order_relaxed);
+  r->spans[h & (RING_SIZE - 1)] = Span{name, startNs, endNs};
+  r->head.store(h + 1, std::memory_order_release);
+}
+
+bool trace::flush() {
+  if (outputPath.empty())
+    return false;
+
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  FILE *f = std::fopen(outputPath.c_str(), "w");
+  if (!f)
+    return false;
+
+  std::fprintf(f, "{\"traceEvents\":[");
+  bool first = true;
+  for (const Ring *r : rings) {
+    uint64_t h = r->head.load(std::memory_order_acquire);
+    uint64_t keep = RING_SIZE - RING_MARGIN;
+    uint64_t begin = h > keep ? h - keep : 0;
+    for (uint64_t i = begin; i < h; ++i) {
+      const Span &s = r->spans[i & (RING_SIZE - 1)];
+      if (s.start < startTime || s.end < s.start)
+        continue;
+      std::fprintf(f,
+                   "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                   "\"ts\":%.3f,\"dur\":%.3f}",
+                   first ? "" : ",", s.name, int(getpid()), r->tid,
+                   (s.start - startTime) / 1000.0,
+                   (s.end - s.start) / 1000.0);
+      first = false;
+    }
+  }
+  std::fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  return std::fclose(f) == 0;
+}
+
+#endif // TRACING
@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Scoped trace spans, written as a Chrome/Perfetto JSON trace file.
+//
+// Compiled in only with CONFIG+=tracing (which defines TRACING), otherwise
+// TRACE_SCOPE expands to nothing. When compiled in, spans are recorded only
+// if the DINO_TRACE environment variable names the output file. The file is
+// written on exit and whenever the process gets SIGUSR1.
+//
+// Each thread records into its own ring buffer without locks; when a ring
+// is full the oldest spans are overwritten.
+
+#ifdef TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> active;
+}
+
+// Reads DINO_TRACE and installs the exit and SIGUSR1 handlers
+void init();
+// Writes every recorded span to the trace file
+bool flush();
+void record(const char *name, uint64_t startNs, uint64_t endNs);
+
+inline bool enabled() {
+  return detail::active.load(std::memory_order_relaxed);
+}
+
+inline uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// name must be a string literal (only the pointer is stored)
+class Scope {
+public:
+  explicit Scope(const char *name)
+      : name(name), start(enabled() ? now() : 0) {}
+  ~Scope() {
+    if (start)
+      record(name, start, now());
+  }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+private:
+  const char *name;
+  uint64_t start;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_INIT() trace::init()
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_INIT()
+
+#endif // TRACING
+
+#endif // TRACE_H
@@ -0,0 +1,47 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Latest-value mailbox for exactly one writer thread and one reader thread,
+// without locks. The writer fills back() and publish()es it; the reader
+// calls update() to take the newest published value and then reads front()
+// for as long as it likes. Neither side ever waits for the other: values
+// the reader did not get to are overwritten, and the slot being read is
+// never written.
+template <typename T> class TripleBuffer {
+public:
+  // Writer side
+  T &back() { return slots[backIndex].value; }
+  void publish() {
+    int old = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+    backIndex = old & INDEX;
+  }
+
+  // Reader side. Returns false, keeping front(), if nothing was published
+  // since the last update().
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH))
+      return false;
+    int old = middle.exchange(frontIndex, std::memory_order_acq_rel);
+    frontIndex = old & INDEX;
+    return true;
+  }
+  const T &front() const { return slots[frontIndex].value; }
+
+private:
+  static const int INDEX = 3;
+  static const int FRESH = 4;
+
+  // each slot and index on its own cache lines
+  struct Slot {
+    alignas(64) T value{};
+  };
+  Slot slots[3];
+  alignas(64) std::atomic<int> middle{1}; // slot index | FRESH
+  alignas(64) int backIndex = 0;          // writer only
+  alignas(64) int frontIndex = 2;         // reader only
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,279 @@
+#include "dinoEnv.h"
+#include "batchSim.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const float STEP = 1.f / 120.f;
+const float DINO_X = 40.f; // as in GameState::reset()
+
+uint64_t align64(uint64_t n) { return (n + 63) & ~uint64_t(63); }
+
+// Sets bits [x0, x1) of a row of words
+void fillSpan(uint64_t *row, int x0, int x1) {
+  while (x0 < x1) {
+    int bit = x0 & 63;
+    int n = std::min(64 - bit, x1 - x0);
+    uint64_t bits = n == 64 ? ~uint64_t(0) : ((uint64_t(1) << n) - 1) << bit;
+    row[x0 >> 6] |= bits;
+    x0 += n;
+  }
+}
+
+} // namespace
+
+struct DinoEnv {
+  explicit DinoEnv(int envs) : sim(envs), ducking(envs), lastScores(envs) {}
+
+  BatchSim sim;
+  std::vector<uint8_t> ducking; // duck held on the previous step
+  std::vector<int> lastScores;
+  std::vector<GameInput> inputs;
+
+  std::string shmName;
+  void *region = nullptr;
+  DinoEnvHeader *header = nullptr;
+  float *obs = nullptr;
+  float *rewards = nullptr;
+  uint8_t *dones = nullptr;
+  uint8_t *actions = nullptr;
+  uint64_t *frames = nullptr;
+  int frameScale = 0;
+  int frameWords = 0; // per row
+  uint64_t steps = 0;  // published to the header as step_count
+
+  void observe(int e);
+  void render(int e);
+};
+
+void DinoEnv::observe(int e) {
+  const GameConfig &cfg = sim.config();
+  float *o = obs + size_t(e) * DINO_OBS_SIZE;
+  o[0] = sim.dinoY(e) / cfg.groundY;
+  o[1] = sim.dinoVy(e) / -cfg.jumpV;
+  o[2] = sim.isOnGround(e);
+  o[3] = sim.isCrouching(e);
+  o[4] = sim.speed(e) / cfg.maxSpeed;
+
+  // nearest obstacles not yet behind the dino, clouds are scenery
+  struct Near {
+    GameRect r;
+    bool bird;
+  } near[2 * BatchSim::SLOTS];
+  int n = 0;
+  for (int k = BatchSim::CACTUS; k <= BatchSim::BIRD; ++k) {
+    BatchSim::Kind kind = BatchSim::Kind(k);
+    for (int i = 0; i < sim.obstacleCount(kind, e); ++i) {
+      GameRect r = sim.obstacle(kind, e, i);
+      if (r.x + r.w > DINO_X)
+        near[n++] = {r, kind == BatchSim::BIRD};
+    }
+  }
+  std::sort(near, near + n,
+            [](const Near &a, const Near &b) { return a.r.x < b.r.x; });
+
+  for (int i = 0; i < DINO_OBS_OBSTACLES; ++i) {
+    float *p = o + 5 + 5 * i;
+    if (i < n) {
+      const GameRect &r = near[i].r;
+      p[0] = (r.x - DINO_X) / cfg.width;
+      p[1] = r.y / cfg.groundY;
+      p[2] = r.w / cfg.width;
+      p[3] = r.h / cfg.groundY;
+      p[4] = near[i].bird;
+    } else {
+      p[0] = 1.f;
+      p[1] = p[2] = p[3] = p[4] = 0.f;
+    }
+  }
+}
+
+// Dino and obstacles as filled boxes, any frame pixel a box touches is set
+void DinoEnv::render(int e) {
+  const int height = header->frame_height;
+  uint64_t *frame = frames + size_t(e) * height * frameWords;
+  std::memset(frame, 0, size_t(height) * frameWords * sizeof(uint64_t));
+
+  auto box = [&](const GameRect &r) {
+    int x0 = std::max(0, int(std::floor(r.x / frameScale)));
+    int x1 = std::min(int(header->frame_width),
+                      int(std::ceil((r.x + r.w) / frameScale)));
+    int y0 = std::max(0, int(std::floor(r.y / frameScale)));
+    int y1 = std::min(height, int(std::ceil((r.y + r.h) / frameScale)));
+    for (int y = y0; y < y1; ++y)
+      fillSpan(frame + size_t(y) * frameWords, x0, x1);
+  };
+
+  box(GameRect{DINO_X, sim.dinoY(e), float(sim.config().dinoW),
+               sim.dinoHeight(e)});
+  for (int k = BatchSim::CACTUS; k <= BatchSim::BIRD; ++k) {
+    BatchSim::Kind kind = BatchSim::Kind(k);
+    for (int i = 0; i < sim.obstacleCount(kind, e); ++i)
+      box(sim.obstacle(kind, e, i));
+  }
+}
+
+extern "C" {
+
+DinoEnv *dino_env_create(int num_envs, const char *shm_name,
+                         int frame_scale) {
+  if (num_envs <= 0 || frame_scale < 0)
+    return nullptr;
+
+  DinoEnv *env = new DinoEnv(num_envs);
+  env->inputs.resize(num_envs);
+  const GameConfig &cfg = env->sim.config();
+
+  // the frame covers the playfield above the ground line
+  uint32_t frameW = 0, frameH = 0;
+  if (frame_scale > 0) {
+    env->frameScale = frame_scale;
+    frameW = (cfg.width + frame_scale - 1) / frame_scale;
+    frameH = (cfg.groundY + frame_scale - 1) / frame_scale;
+    env->frameWords = (frameW + 63) / 64;
+  }
+
+  DinoEnvHeader h = {};
+  h.magic = DINO_ENV_MAGIC;
+  h.version = DINO_ENV_VERSION;
+  h.num_envs = num_envs;
+  h.obs_size = DINO_OBS_SIZE;
+  h.frame_width = frameW;
+  h.frame_height = frameH;
+  h.frame_stride = env->frameWords * sizeof(uint64_t);
+  uint64_t at = align64(sizeof(DinoEnvHeader));
+  h.obs_offset = at;
+  at = align64(at + uint64_t(num_envs) * DINO_OBS_SIZE * sizeof(float));
+  h.reward_offset = at;
+  at = align64(at + uint64_t(num_envs) * sizeof(float));
+  h.done_offset = at;
+  at = align64(at + num_envs);
+  h.action_offset = at;
+  at = align64(at + num_envs);
+  h.frame_offset = at;
+  at += uint64_t(num_envs) * frameH * h.frame_stride;
+  h.size = at;
+
+  void *region = MAP_FAILED;
+  if (shm_name) {
+    int fd = shm_open(shm_name, O_CREAT | O_RDWR, 0600);
+    if (fd >= 0) {
+      if (ftruncate(fd, h.size) == 0)
+        region = mmap(nullptr, h.size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+      close(fd);
+      if (region == MAP_FAILED)
+        shm_unlink(shm_name);
+      else
+        env->shmName = shm_name;
+    }
+  } else {
+    region = mmap(nullptr, h.size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (region == MAP_FAILED) {
+    delete env;
+    return nullptr;
+  }
+
+  char *base = static_cast<char *>(region);
+  std::memset(base, 0, h.size);
+  std::memcpy(base, &h, sizeof(h));
+  env->region = region;
+  env->header = reinterpret_cast<DinoEnvHeader *>(base);
+  env->obs = reinterpret_cast<float *>(base + h.obs_offset);
+  env->rewards = reinterpret_cast<float *>(base + h.reward_offset);
+  env->dones = reinterpret_cast<uint8_t *>(base + h.done_offset);
+  env->actions = reinterpret_cast<uint8_t *>(base + h.action_offset);
+  env->frames = reinterpret_cast<uint64_t *>(base + h.frame_offset);
+  return env;
+}
+
+void dino_env_destroy(DinoEnv *env) {
+  if (!env)
+    return;
+  munmap(env->region, env->header->size);
+  if (!env->shmName.empty())
+    shm_unlink(env->shmName.c_str());
+  delete env;
+}
+
+void dino_env_reset_one(DinoEnv *env, int index, uint32_t seed) {
+  // running from the start, an agent's first action is a real choice
+  env->sim.reset(index, seed);
+  env->sim.start(index);
+  env->ducking[index] = false;
+  env->lastScores[index] = 0;
+  env->rewards[index] = 0.f;
+  env->dones[index] = 0;
+  env->observe(index);
+  if (env->frameScale)
+    env->render(index);
+}
+
+void dino_env_reset(DinoEnv *env, uint32_t seed) {
+  for (int e = 0; e < env->sim.size(); ++e)
+    dino_env_reset_one(env, e, seed + e);
+}
+
+void dino_env_step(DinoEnv *env, const uint8_t *actions) {
+  const int envs = env->sim.size();
+  if (!actions)
+    actions = env->actions;
+
+  // actions are levels, the game wants key edges
+  for (int e = 0; e < envs; ++e) {
+    bool duck = actions[e] == DINO_ACTION_DUCK;
+    GameInput &in = env->inputs[e];
+    in.jumpPressed = actions[e] == DINO_ACTION_JUMP;
+    in.duckPressed = duck && !env->ducking[e];
+    in.duckReleased = !duck && env->ducking[e];
+    env->ducking[e] = duck;
+  }
+  env->sim.step(env->inputs.data(), STEP);
+
+  for (int e = 0; e < envs; ++e) {
+    if (env->dones[e]) {
+      env->rewards[e] = 0.f;
+      continue;
+    }
+    int score = env->sim.score(e);
+    env->rewards[e] = float(score - env->lastScores[e]);
+    env->lastScores[e] = score;
+    if (env->sim.gameOver(e)) {
+      env->rewards[e] += DINO_REWARD_DEATH;
+      env->dones[e] = 1;
+    }
+    env->observe(e);
+    if (env->frameScale)
+      env->render(e);
+  }
+
+  // a reader polling step_count sees the buffers of that step
+  __atomic_store_n(&env->header->step_count, ++env->steps, __ATOMIC_RELEASE);
+}
+
+DinoEnvHeader *dino_env_header(DinoEnv *env) { return env->header; }
+
+const float *dino_env_observations(const DinoEnv *env) { return env->obs; }
+
+const float *dino_env_rewards(const DinoEnv *env) { return env->rewards; }
+
+const uint8_t *dino_env_dones(const DinoEnv *env) { return env->dones; }
+
+uint8_t *dino_env_actions(DinoEnv *env) { return env->actions; }
+
+const uint64_t *dino_env_frame(const DinoEnv *env, int index) {
+  if (!env->frameScale)
+    return nullptr;
+  return env->frames + size_t(index) * env->header->frame_height *
+                           env->frameWords;
+}
+
+} // extern "C"
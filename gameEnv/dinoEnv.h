@@ -0,0 +1,93 @@
+#ifndef DINOENV_H
+#define DINOENV_H
+
+/* Gym-style C interface to the game rules for training agents.
+ *
+ * One DinoEnv runs num_envs independent games in lockstep (BatchSim).
+ * Observations, rewards, done flags, actions and the optional 1-bit frames
+ * live in one memory region. When a shared memory name is given the region
+ * is a POSIX shared memory object, so a trainer in another process can map
+ * it (see DinoEnvHeader for the layout) and read whole batches without
+ * copies.
+ *
+ * Actions per env: DINO_ACTION_NONE stands (and stops ducking),
+ * DINO_ACTION_JUMP jumps when on the ground, DINO_ACTION_DUCK ducks for as
+ * long as it is given.
+ *
+ * Reward per step is the score gained (the score is distance / 10), and
+ * DINO_REWARD_DEATH on the step the env dies. A done env stays frozen
+ * until it is reset. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DINO_ENV_MAGIC 0x564e4544u /* "DENV" */
+#define DINO_ENV_VERSION 1u
+
+/* observation: dino y, vy, on ground, ducking, speed, then the
+ * DINO_OBS_OBSTACLES nearest obstacles ahead as (dx, y, w, h, is bird),
+ * all scaled to about [-1, 1]. Missing obstacles are (1, 0, 0, 0, 0). */
+#define DINO_OBS_OBSTACLES 3
+#define DINO_OBS_SIZE (5 + 5 * DINO_OBS_OBSTACLES)
+
+#define DINO_REWARD_DEATH (-10.f)
+
+enum DinoAction {
+  DINO_ACTION_NONE = 0,
+  DINO_ACTION_JUMP = 1,
+  DINO_ACTION_DUCK = 2
+};
+
+/* Start of the memory region. Offsets are in bytes from the header, every
+ * array is 64 byte aligned and has one entry (or frame) per env. */
+typedef struct DinoEnvHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_envs;
+  uint32_t obs_size;       /* floats per observation */
+  uint32_t frame_width;    /* 0 when frames are off */
+  uint32_t frame_height;
+  uint32_t frame_stride;   /* bytes per frame row, whole uint64_t words */
+  uint32_t reserved;
+  uint64_t step_count;     /* steps so far, written last by each step */
+  uint64_t obs_offset;     /* float[num_envs][obs_size] */
+  uint64_t reward_offset;  /* float[num_envs] */
+  uint64_t done_offset;    /* uint8_t[num_envs] */
+  uint64_t action_offset;  /* uint8_t[num_envs], read by step(NULL) */
+  uint64_t frame_offset;   /* uint64_t rows, bit x of a row is pixel x */
+  uint64_t size;           /* whole region */
+} DinoEnvHeader;
+
+typedef struct DinoEnv DinoEnv;
+
+/* shm_name: POSIX shared memory name such as "/dino", NULL for private
+ * memory. frame_scale: playfield pixels per frame pixel, 0 for no frames.
+ * Returns NULL on failure. */
+DinoEnv *dino_env_create(int num_envs, const char *shm_name, int frame_scale);
+/* Unmaps the region and removes the shared memory name */
+void dino_env_destroy(DinoEnv *env);
+
+/* Resets every env, env i with seed + i, and writes observations */
+void dino_env_reset(DinoEnv *env, uint32_t seed);
+void dino_env_reset_one(DinoEnv *env, int index, uint32_t seed);
+
+/* Advances every env by one simulation step (1/120 s). actions holds one
+ * DinoAction per env; NULL takes them from the region's action array. */
+void dino_env_step(DinoEnv *env, const uint8_t *actions);
+
+DinoEnvHeader *dino_env_header(DinoEnv *env);
+const float *dino_env_observations(const DinoEnv *env);
+const float *dino_env_rewards(const DinoEnv *env);
+const uint8_t *dino_env_dones(const DinoEnv *env);
+uint8_t *dino_env_actions(DinoEnv *env);
+/* frame of env index, frame_height rows of frame_stride bytes */
+const uint64_t *dino_env_frame(const DinoEnv *env, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DINOENV_H */
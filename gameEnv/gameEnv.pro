@@ -0,0 +1,17 @@
+# Shared library with the C environment interface in dinoEnv.h, for
+# training agents from other languages. No Qt.
+TEMPLATE = lib
+CONFIG += c++17 shared
+CONFIG -= qt
+
+TARGET = dinoEnv
+
+SOURCES += \
+    dinoEnv.cpp
+
+HEADERS += \
+    dinoEnv.h
+
+include(../gameCore/gameCore.pri)
+
+LIBS += -lrt
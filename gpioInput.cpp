@@ -0,0 +1,395 @@
+#include "gpioInput.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBGPIOD
+#include <gpiod.h>
+#endif
+
+const GpioInput::Line GpioInput::LINES[GPIO_BUTTONS] = {
+    {"/dev/gpiochip0", 26, 26},
+    {"/dev/gpiochip1", 14, 46},
+};
+
+int64_t monotonicNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void Debouncer::reset(bool level) {
+  stable = raw = level;
+  rawTime = lockedUntil = 0;
+}
+
+bool Debouncer::edge(bool level, int64_t timeNs) {
+  raw = level;
+  rawTime = timeNs;
+  if (timeNs < lockedUntil || level == stable)
+    return false;
+  stable = level;
+  lockedUntil = timeNs + window;
+  return true;
+}
+
+bool Debouncer::settle(int64_t nowNs, int64_t *timeNs) {
+  if (raw == stable || nowNs < lockedUntil)
+    return false;
+  stable = raw;
+  *timeNs = rawTime;
+  lockedUntil = nowNs + window;
+  return true;
+}
+
+namespace {
+
+#ifdef HAVE_LIBGPIOD
+// One line request per button, the buttons sit on different chips. The
+// kernel timestamps edges with CLOCK_MONOTONIC, libgpiod's default.
+class GpiodBackend : public GpioBackend {
+public:
+  ~GpiodBackend() override {
+    for (gpiod_line_request *r : requests)
+      gpiod_line_request_release(r);
+    if (buffer)
+      gpiod_edge_event_buffer_free(buffer);
+  }
+
+  bool open() {
+    buffer = gpiod_edge_event_buffer_new(16);
+    if (!buffer)
+      return false;
+    for (const GpioInput::Line &line : GpioInput::LINES) {
+      gpiod_line_request *r = request(line);
+      if (!r) {
+        std::fprintf(stderr, "gpiod: cannot request %s line %u: %s\n",
+                     line.chip, line.offset, std::strerror(errno));
+        return false;
+      }
+      requests.push_back(r);
+    }
+    return true;
+  }
+
+  const char *name() const override { return "gpiod"; }
+
+  std::vector<int> fds() const override {
+    std::vector<int> out;
+    for (gpiod_line_request *r : requests)
+      out.push_back(gpiod_line_request_get_fd(r));
+    return out;
+  }
+
+  bool level(int line) override {
+    return gpiod_line_request_get_value(
+               requests[line], GpioInput::LINES[line].offset) ==
+           GPIOD_LINE_VALUE_ACTIVE;
+  }
+
+  bool read(int i, std::vector<Edge> &edges) override {
+    int n = gpiod_line_request_read_edge_events(requests[i], buffer, 16);
+    if (n < 0)
+      return errno == EAGAIN || errno == EINTR;
+    for (int k = 0; k < n; ++k) {
+      gpiod_edge_event *e = gpiod_edge_event_buffer_get_event(buffer, k);
+      bool rising = gpiod_edge_event_get_event_type(e) ==
+                    GPIOD_EDGE_EVENT_RISING_EDGE;
+      edges.push_back(
+          {i, rising, int64_t(gpiod_edge_event_get_timestamp_ns(e))});
+    }
+    return true;
+  }
+
+private:
+  static gpiod_line_request *request(const GpioInput::Line &line) {
+    gpiod_chip *chip = gpiod_chip_open(line.chip);
+    if (!chip)
+      return nullptr;
+    gpiod_line_settings *settings = gpiod_line_settings_new();
+    gpiod_line_config *lineConfig = gpiod_line_config_new();
+    gpiod_request_config *requestConfig = gpiod_request_config_new();
+    gpiod_line_request *r = nullptr;
+    if (settings && lineConfig && requestConfig) {
+      gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+      gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+      gpiod_line_settings_set_event_clock(settings,
+                                          GPIOD_LINE_CLOCK_MONOTONIC);
+      gpiod_request_config_set_consumer(requestConfig, "dinosaur");
+      if (gpiod_line_config_add_line_settings(lineConfig, &line.offset, 1,
+                                              settings) == 0)
+        r = gpiod_chip_request_lines(chip, requestConfig, lineConfig);
+    }
+    gpiod_request_config_free(requestConfig);
+    gpiod_line_config_free(lineConfig);
+    gpiod_line_settings_free(settings);
+    gpiod_chip_close(chip);
+    return r;
+  }
+
+  std::vector<gpiod_line_request *> requests;
+  gpiod_edge_event_buffer *buffer = nullptr;
+};
+#endif
+
+// The sysfs value file wakes poll() with POLLPRI when the line changes (if
+// the edge file allows it). There is no kernel timestamp, the edge is
+// stamped when the reader thread wakes.
+class SysfsBackend : public GpioBackend {
+public:
+  ~SysfsBackend() override {
+    for (int fd : values)
+      ::close(fd);
+  }
+
+  bool open() {
+    for (const GpioInput::Line &line : GpioInput::LINES) {
+      char path[64];
+      std::snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/edge",
+                    line.sysfsNumber);
+      int edgeFd = ::open(path, O_WRONLY);
+      if (edgeFd >= 0) {
+        if (::write(edgeFd, "both", 4) != 4)
+          std::fprintf(stderr, "sysfs: cannot set %s\n", path);
+        ::close(edgeFd);
+      }
+      std::snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/value",
+                    line.sysfsNumber);
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0) {
+        std::fprintf(stderr, "sysfs: cannot open %s: %s\n", path,
+                     std::strerror(errno));
+        return false;
+      }
+      values.push_back(fd);
+    }
+    return true;
+  }
+
+  const char *name() const override { return "sysfs"; }
+  // always readable, a change raises POLLPRI
+  short pollEvents() const override { return POLLPRI; }
+  std::vector<int> fds() const override { return values; }
+
+  bool level(int line) override {
+    char c = '0';
+    lseek(values[line], 0, SEEK_SET);
+    return ::read(values[line], &c, 1) == 1 && c == '1';
+  }
+
+  bool read(int i, std::vector<Edge> &edges) override {
+    int64_t now = monotonicNs();
+    edges.push_back({i, level(i), now});
+    return true;
+  }
+
+private:
+  std::vector<int> values;
+};
+
+// Reads "<line> <level> [<timeNs>]" lines from a pipe or FIFO. Opened
+// read-write so it neither blocks waiting for a writer nor sees end of file
+// when the writer closes.
+class FakeBackend : public GpioBackend {
+public:
+  ~FakeBackend() override {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  bool open(const char *path) {
+    fd = ::open(path, O_RDWR | O_NONBLOCK);
+    if (fd < 0)
+      std::fprintf(stderr, "fake gpio: cannot open %s: %s\n", path,
+                   std::strerror(errno));
+    return fd >= 0;
+  }
+
+  const char *name() const override { return "fake"; }
+  std::vector<int> fds() const override { return {fd}; }
+  bool level(int line) override { return levels[line]; }
+
+  bool read(int, std::vector<Edge> &edges) override {
+    char buf[256];
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0)
+      return n < 0 && (errno == EAGAIN || errno == EINTR);
+    int64_t now = monotonicNs();
+    pending.append(buf, n);
+
+    size_t end;
+    while ((end = pending.find('\n')) != std::string::npos) {
+      int line = -1, value = 0;
+      long long timeNs = 0;
+      std::string text = pending.substr(0, end);
+      pending.erase(0, end + 1);
+      int fields =
+          std::sscanf(text.c_str(), "%d %d %lld", &line, &value, &timeNs);
+      if (fields < 2 || line < 0 || line >= GPIO_BUTTONS)
+        continue;
+      levels[line] = value != 0;
+      edges.push_back({line, levels[line], fields == 3 ? timeNs : now});
+    }
+    return true;
+  }
+
+private:
+  int fd = -1;
+  bool levels[GPIO_BUTTONS] = {};
+  std::string pending;
+};
+
+std::unique_ptr<GpioBackend> openBackend() {
+  const char *choice = std::getenv("DINO_GPIO");
+  std::string which = choice ? choice : "";
+
+  if (which.compare(0, 5, "fake:") == 0) {
+    FakeBackend *fake = new FakeBackend;
+    std::unique_ptr<GpioBackend> owned(fake);
+    if (fake->open(which.c_str() + 5))
+      return owned;
+    return nullptr;
+  }
+#ifdef HAVE_LIBGPIOD
+  if (which.empty() || which == "gpiod") {
+    GpiodBackend *gpiod = new GpiodBackend;
+    std::unique_ptr<GpioBackend> owned(gpiod);
+    if (gpiod->open())
+      return owned;
+    if (!which.empty())
+      return nullptr;
+  }
+#endif
+  if (which.empty() || which == "sysfs") {
+    SysfsBackend *sysfs = new SysfsBackend;
+    std::unique_ptr<GpioBackend> owned(sysfs);
+    if (sysfs->open())
+      return owned;
+    return nullptr;
+  }
+  std::fprintf(stderr, "DINO_GPIO: unknown backend %s\n", which.c_str());
+  return nullptr;
+}
+
+} // namespace
+
+GpioInput::GpioInput() {
+  wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  stopFd = eventfd(0, EFD_CLOEXEC);
+}
+
+GpioInput::~GpioInput() {
+  stop();
+  ::close(wakeFd);
+  ::close(stopFd);
+}
+
+const char *GpioInput::backendName() const {
+  return backend ? backend->name() : "none";
+}
+
+bool GpioInput::start(int priority) {
+  stop();
+  backend = openBackend();
+  if (!backend || wakeFd < 0 || stopFd < 0)
+    return false;
+  for (int line = 0; line < GPIO_BUTTONS; ++line)
+    debouncers[line].reset(backend->level(line));
+
+  thread = std::thread(&GpioInput::run, this);
+  if (priority > 0) {
+    sched_param param = {};
+    param.sched_priority = priority;
+    int err = pthread_setschedparam(thread.native_handle(), SCHED_FIFO,
+                                    &param);
+    if (err)
+      std::fprintf(stderr, "gpio: no real-time priority: %s\n",
+                   std::strerror(err));
+  }
+  return true;
+}
+
+void GpioInput::stop() {
+  if (!thread.joinable())
+    return;
+  uint64_t one = 1;
+  if (::write(stopFd, &one, sizeof(one)) == sizeof(one))
+    thread.join();
+  else
+    thread.detach();
+  uint64_t count;
+  while (::read(stopFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+  }
+}
+
+void GpioInput::drain() {
+  uint64_t count;
+  while (::read(wakeFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+  }
+}
+
+void GpioInput::push(int line, bool pressed, int64_t timeNs) {
+  if (!queue.push({line, pressed, timeNs})) {
+    droppedCount.fetch_add(1);
+    return;
+  }
+  // fails only if the counter is full, and then the consumer is awake
+  uint64_t one = 1;
+  ssize_t written = ::write(wakeFd, &one, sizeof(one));
+  (void)written;
+}
+
+void GpioInput::run() {
+  std::vector<pollfd> fds;
+  for (int fd : backend->fds())
+    fds.push_back({fd, backend->pollEvents(), 0});
+  fds.push_back({stopFd, POLLIN, 0});
+
+  std::vector<GpioBackend::Edge> edges;
+  for (;;) {
+    // wake up for the earliest debounce window that needs settling
+    int timeout = -1;
+    for (const Debouncer &d : debouncers) {
+      int64_t deadline = d.deadline();
+      if (deadline < 0)
+        continue;
+      int64_t wait = deadline - monotonicNs();
+      int ms = wait <= 0 ? 0 : int((wait + 999999) / 1000000);
+      timeout = timeout < 0 ? ms : std::min(timeout, ms);
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) < 0) {
+      if (errno == EINTR)
+        continue;
+      std::fprintf(stderr, "gpio: poll failed: %s\n", std::strerror(errno));
+      return;
+    }
+    if (fds.back().revents)
+      return;
+
+    for (size_t i = 0; i + 1 < fds.size(); ++i) {
+      if (!fds[i].revents)
+        continue;
+      edges.clear();
+      if (!backend->read(int(i), edges))
+        fds[i].fd = -1; // gone, poll() skips negative descriptors
+      for (const GpioBackend::Edge &e : edges)
+        if (debouncers[e.line].edge(e.level, e.timeNs))
+          push(e.line, e.level, e.timeNs);
+    }
+
+    int64_t now = monotonicNs();
+    for (int line = 0; line < GPIO_BUTTONS; ++line) {
+      int64_t timeNs;
+      if (debouncers[line].settle(now, &timeNs))
+        push(line, debouncers[line].level(), timeNs);
+    }
+  }
+}
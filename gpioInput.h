@@ -0,0 +1,123 @@
+#ifndef GPIOINPUT_H
+#define GPIOINPUT_H
+
+#include "spscQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Button input read on its own thread, independent of the GUI event loop.
+//
+// The backend is picked by the DINO_GPIO environment variable:
+//   gpiod        GPIO character device through libgpiod v2, with kernel
+//                edge timestamps (needs a build with libgpiod)
+//   sysfs        /sys/class/gpio/gpioN/value, timestamped on wakeup
+//   fake:<path>  a pipe or FIFO carrying lines of "<line> <level> [<ns>]",
+//                for tests without hardware
+// Unset, gpiod is tried first and sysfs is the fallback.
+//
+// Edges pass a software debounce filter and are queued for the consumer,
+// which waits on notifyFd() becoming readable.
+
+// Buttons, in the order of GpioInput::LINES
+enum GpioButton { GPIO_UP, GPIO_DOWN, GPIO_BUTTONS };
+
+struct GpioEvent {
+  int line;       // GpioButton
+  bool pressed;   // the line went high
+  int64_t timeNs; // CLOCK_MONOTONIC
+};
+
+// CLOCK_MONOTONIC in nanoseconds, the clock of GpioEvent::timeNs
+int64_t monotonicNs();
+
+// Lockout debounce for one line. The first edge that changes the level is
+// taken at once, so debouncing adds no latency; edges in the following
+// window are bounce. If the line settled on a different level by the end
+// of the window, settle() reports that as a late edge.
+class Debouncer {
+public:
+  explicit Debouncer(int64_t windowNs = 5000000) : window(windowNs) {}
+
+  void reset(bool level);
+  // Feeds a raw edge. Returns true if the debounced level changed.
+  bool edge(bool level, int64_t timeNs);
+  // When settle() has to run, or -1 if the line is settled
+  int64_t deadline() const { return raw != stable ? lockedUntil : -1; }
+  // Returns true if the level changed, with the time of the raw edge
+  bool settle(int64_t nowNs, int64_t *timeNs);
+  bool level() const { return stable; }
+
+private:
+  int64_t window;
+  bool stable = false;
+  bool raw = false;
+  int64_t rawTime = 0;
+  int64_t lockedUntil = 0;
+};
+
+// Source of raw edges, see gpioInput.cpp
+class GpioBackend {
+public:
+  struct Edge {
+    int line;
+    bool level;
+    int64_t timeNs;
+  };
+
+  virtual ~GpioBackend() {}
+  virtual const char *name() const = 0;
+  // Descriptors to poll, and what to poll them for
+  virtual std::vector<int> fds() const = 0;
+  virtual short pollEvents() const { return POLLIN; }
+  virtual bool level(int line) = 0;
+  // Reads what is pending on fds()[i]. Returns false if the source is gone.
+  virtual bool read(int i, std::vector<Edge> &edges) = 0;
+};
+
+class GpioInput {
+public:
+  struct Line {
+    const char *chip;   // character device
+    unsigned offset;    // line on that chip
+    int sysfsNumber;    // /sys/class/gpio/gpio<N>
+  };
+  // BeagleBone Black P8.14 (up) and P8.16 (down)
+  static const Line LINES[GPIO_BUTTONS];
+
+  GpioInput();
+  ~GpioInput();
+
+  // Opens the backend chosen by DINO_GPIO and starts the reader thread at
+  // the given SCHED_FIFO priority (0 for normal scheduling). Returns false
+  // if no backend could be opened.
+  bool start(int priority = 50);
+  void stop();
+
+  const char *backendName() const;
+  // Readable while events are queued, see drain()
+  int notifyFd() const { return wakeFd; }
+  // Consumer side: clears notifyFd() and pops the next event
+  void drain();
+  bool pop(GpioEvent &event) { return queue.pop(event); }
+  // Events lost to a full queue
+  uint64_t dropped() const { return droppedCount.load(); }
+
+private:
+  void run();
+  void push(int line, bool pressed, int64_t timeNs);
+
+  std::unique_ptr<GpioBackend> backend;
+  Debouncer debouncers[GPIO_BUTTONS];
+  SpscQueue<GpioEvent, 256> queue;
+  std::atomic<uint64_t> droppedCount{0};
+  std::thread thread;
+  int wakeFd = -1; // eventfd, reader -> consumer
+  int stopFd = -1; // eventfd, stop() -> reader
+};
+
+#endif // GPIOINPUT_H
@@ -1,68 +1,40 @@
 #include "gpioKeys.h"
+#include "trace.h"
 #include <QDebug>
-#include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
-#include <string.h>
 
 GpioKeys::GpioKeys(QObject *parent)
     : QObject(parent),
-      lastUpValue('0'),
-      lastDownValue('0')
+      notifier(nullptr)
 {
-    // ---------- UP : GPIO26 ----------
-    fdUp = open("/sys/class/gpio/gpio26/value", O_RDONLY);
-    if (fdUp < 0) {
-        qDebug() << "Failed to open gpio26:" << strerror(errno);
-    } else {
-        notifierUp = new QSocketNotifier(fdUp, QSocketNotifier::Read, this);
-        connect(notifierUp, &QSocketNotifier::activated,
-                this, &GpioKeys::handleUp);
+    // UP : GPIO26, DOWN : GPIO46, see GpioInput::LINES
+    if (!input.start()) {
+        qDebug() << "No GPIO buttons, backend" << input.backendName();
+        return;
     }
+    qDebug() << "GPIO buttons via" << input.backendName();
 
-    // ---------- DOWN : GPIO46 ----------
-    fdDown = open("/sys/class/gpio/gpio46/value", O_RDONLY);
-    if (fdDown < 0) {
-        qDebug() << "Failed to open gpio46:" << strerror(errno);
-    } else {
-        notifierDown = new QSocketNotifier(fdDown, QSocketNotifier::Read, this);
-        connect(notifierDown, &QSocketNotifier::activated,
-                this, &GpioKeys::handleDown);
-    }
-}
-
-void GpioKeys::handleUp() {
-    char buf = '0';
-    lseek(fdUp, 0, SEEK_SET);
-    if (read(fdUp, &buf, 1) <= 0) return;
-
-    // 0 -> 1 Press
-    if (lastUpValue == '0' && buf == '1') {
-        emit keyUpPressed();
-    }
-
-    // 1 -> 0 Release
-    if (lastUpValue == '1' && buf == '0') {
-        emit keyUpReleased();
-    }
-
-    lastUpValue = buf;
+    notifier = new QSocketNotifier(input.notifyFd(), QSocketNotifier::Read,
+                                   this);
+    connect(notifier, &QSocketNotifier::activated,
+            this, &GpioKeys::handleEvents);
 }
 
-void GpioKeys::handleDown() {
-    char buf = '0';
-    lseek(fdDown, 0, SEEK_SET);
-    if (read(fdDown, &buf, 1) <= 0) return;
-
-    // 0 -> 1 Press
-    if (lastDownValue == '0' && buf == '1') {
-        emit keyDownPressed();
+void GpioKeys::handleEvents() {
+    TRACE_SCOPE("GpioKeys::handleEvents");
+    input.drain();
+
+    GpioEvent event;
+    while (input.pop(event)) {
+        if (event.line == GPIO_UP) {
+            if (event.pressed)
+                emit keyUpPressed(event.timeNs);
+            else
+                emit keyUpReleased(event.timeNs);
+        } else {
+            if (event.pressed)
+                emit keyDownPressed(event.timeNs);
+            else
+                emit keyDownReleased(event.timeNs);
+        }
     }
-
-    // 1 -> 0 Release
-    if (lastDownValue == '1' && buf == '0') {
-        emit keyDownReleased();
-    }
-
-    lastDownValue = buf;
 }
@@ -1,32 +1,29 @@
 #ifndef GPIOKEYS_H
 #define GPIOKEYS_H
 
+#include "gpioInput.h"
 #include <QObject>
 #include <QSocketNotifier>
 
+// Delivers the buttons read by GpioInput on the GUI thread. timeNs is when
+// the edge happened, on the monotonicNs() clock.
 class GpioKeys : public QObject {
     Q_OBJECT
 public:
     explicit GpioKeys(QObject *parent = nullptr);
 
 signals:
-    void keyUpPressed();
-    void keyDownPressed();
-    void keyDownReleased();
-    void keyUpReleased();
+    void keyUpPressed(qint64 timeNs);
+    void keyDownPressed(qint64 timeNs);
+    void keyDownReleased(qint64 timeNs);
+    void keyUpReleased(qint64 timeNs);
 
 private slots:
-    void handleUp();
-    void handleDown();
+    void handleEvents();
 
 private:
-    int fdUp;
-    int fdDown;
-    QSocketNotifier *notifierUp;
-    QSocketNotifier *notifierDown;
-
-    char lastUpValue;
-    char lastDownValue;
+    GpioInput input;
+    QSocketNotifier *notifier;
 };
 
 #endif
@@ -1,10 +1,159 @@
+#include "dinosaur.h"
 #include "mainWindow.h"
+#include "trace.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// Plays a scripted run, drawing every frame both through Qt and into the
+// framebuffer given by spec (see FbDevice, e.g. /tmp/fb.raw:480x272x16),
+// and compares them. Differing frames are saved as PNGs. Returns the number
+// of differing frames, or -1 if the framebuffer cannot be opened.
+static int fbCheck(const QString &spec, int frames) {
+    qputenv("DINO_FB", spec.toLocal8Bit());
+    dinosaur game;
+    if (!game.hasFb())
+        return -1;
+
+    // RGB565 has 5 or 6 bit channels, Qt blends into it a little
+    // differently than into 32 bits
+    const int tolerance = game.fbFrame().depth() == 16 ? 8 : 0;
+    GameState &state = game.state();
+    state.reset(1u);
+    int differing = 0;
+    for (int i = 0; i < frames; ++i) {
+        if (state.gameOver)
+            state.reset(uint32_t(i));
+        GameInput input;
+        input.jumpPressed = i % 45 == 0;
+        state.step(input, 1.f / 120.f);
+        state.step(GameInput(), 1.f / 120.f);
+
+        game.renderToFb();
+        QImage fbImage = game.fbFrame();
+        QImage qtImage = game.grab().toImage().convertToFormat(
+            fbImage.format());
+        fbImage = fbImage.convertToFormat(QImage::Format_RGB32);
+        qtImage = qtImage.convertToFormat(QImage::Format_RGB32);
+
+        int worst = 0;
+        for (int y = 0; y < qtImage.height(); ++y) {
+            const QRgb *a = reinterpret_cast<const QRgb *>(qtImage.scanLine(y));
+            const QRgb *b = reinterpret_cast<const QRgb *>(fbImage.scanLine(y));
+            for (int x = 0; x < qtImage.width(); ++x) {
+                worst = qMax(worst, qAbs(qRed(a[x]) - qRed(b[x])));
+                worst = qMax(worst, qAbs(qGreen(a[x]) - qGreen(b[x])));
+                worst = qMax(worst, qAbs(qBlue(a[x]) - qBlue(b[x])));
+            }
+        }
+        if (worst > tolerance) {
+            if (differing < 3) {
+                qtImage.save(QString("fbcheck-%1-qt.png").arg(i));
+                fbImage.save(QString("fbcheck-%1-fb.png").arg(i));
+            }
+            ++differing;
+        }
+    }
+    return differing;
+}
 
 int main(int argc, char *argv[]) {
+    TRACE_INIT();
     QApplication::setAttribute(Qt::AA_DisableHighDpiScaling);
     QApplication app(argc, argv);
 
+    // --replay <file> plays a recorded run (every finished run is saved to
+    // last_run.replay), --headless runs it as fast as possible and prints
+    // the result instead of showing it
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption replayOption("replay",
+                                    "Play the run recorded in <file>.", "file");
+    QCommandLineOption headlessOption(
+        "headless", "With --replay: simulate at full speed, print the result.");
+    QCommandLineOption latencyOption(
+        "latency", "Time <jumps> jumps from press to frame, print p50/p95/p99.",
+        "jumps");
+    parser.addOption(replayOption);
+    parser.addOption(headlessOption);
+    QCommandLineOption fbCheckOption(
+        "fb-check",
+        "Compare <frames> frames drawn by Qt and into the framebuffer <spec>.",
+        "spec");
+    QCommandLineOption framesOption("frames", "Frames for --fb-check.",
+                                    "frames", "600");
+    parser.addOption(latencyOption);
+    parser.addOption(fbCheckOption);
+    parser.addOption(framesOption);
+    parser.process(app);
+
+    // --fb-check <spec> tests the framebuffer renderer against Qt's output
+    if (parser.isSet(fbCheckOption)) {
+        int frames = parser.value(framesOption).toInt();
+        int differing = fbCheck(parser.value(fbCheckOption), frames);
+        if (differing < 0) {
+            qWarning() << "Could not open framebuffer"
+                       << parser.value(fbCheckOption);
+            return 1;
+        }
+        QTextStream(stdout) << frames << " frames, " << differing
+                            << " differ from Qt's\n";
+        return differing ? 1 : 0;
+    }
+
+    // --latency <jumps> measures input-to-frame latency on the game alone;
+    // with DINO_GPIO=fake:<fifo> the presses can come from a script
+    if (parser.isSet(latencyOption)) {
+        int jumps = parser.value(latencyOption).toInt();
+        if (jumps <= 0) {
+            qWarning() << "--latency needs a number of jumps";
+            return 1;
+        }
+        dinosaur game;
+        QObject::connect(&game, &dinosaur::latencyMeasured, &app, [&]() {
+            QTextStream(stdout) << game.latencyReport() << "\n";
+            app.quit();
+        });
+        QObject::connect(&game, &dinosaur::exitToMenu, &app,
+                         &QApplication::quit);
+        game.measureLatency(jumps);
+        game.show();
+        game.setFocus();
+        return app.exec();
+    }
+
+    if (parser.isSet(replayOption)) {
+        Replay replay;
+        if (!replay.load(parser.value(replayOption).toStdString())) {
+            qWarning() << "Could not read replay:"
+                       << parser.value(replayOption);
+            return 1;
+        }
+
+        dinosaur game;
+        if (parser.isSet(headlessOption)) {
+            QElapsedTimer timer;
+            timer.start();
+            uint32_t steps = game.runReplayHeadless(replay);
+            qint64 ns = qMax<qint64>(1, timer.nsecsElapsed());
+            QTextStream(stdout)
+                << "seed " << replay.seed() << " skin " << replay.skin()
+                << " steps " << steps << " score " << game.state().score
+                << (game.state().gameOver ? " (game over)" : "") << " "
+                << qRound64(steps * 1e9 / ns) << " steps/s\n";
+            return 0;
+        }
+
+        QObject::connect(&game, &dinosaur::exitToMenu, &app,
+                         &QApplication::quit);
+        game.show();
+        game.startReplay(replay);
+        game.setFocus();
+        return app.exec();
+    }
+
     MainWindow w;
     w.show();
 
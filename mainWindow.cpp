@@ -1,5 +1,6 @@
 #include "mainWindow.h"
 #include "dinosaur.h"
+#include "spriteBlob.h"
 #include <QEvent>
 #include <QGridLayout>
 #include <QHBoxLayout>
@@ -60,9 +61,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
   btnChar->setFixedHeight(50);
   btnChar->setMaximumWidth(250);
 
-  QPixmap dinoIcon(":/images/images/Dino_Start.png");
-  dinoIcon =
-      dinoIcon.scaled(30, 30, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  QPixmap dinoIcon =
+      QPixmap::fromImage(loadSprite("Dino_Start", QSize(30, 30)));
   btnChar->setIcon(QIcon(dinoIcon));
   btnChar->setIconSize(QSize(30, 30));
 
@@ -73,9 +73,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
   btnLeader->setFixedHeight(50);
   btnLeader->setMaximumWidth(250);
 
-  QPixmap trophyIcon(":/images/images/Trophy.png");
-  trophyIcon =
-      trophyIcon.scaled(30, 30, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  QPixmap trophyIcon = QPixmap::fromImage(loadSprite("Trophy", QSize(30, 30)));
   btnLeader->setIcon(QIcon(trophyIcon));
   btnLeader->setIconSize(QSize(30, 30));
 
@@ -133,28 +131,28 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     previewLabel->setAlignment(Qt::AlignCenter);
     previewLabel->setFixedSize(60, 60);
 
-    QPixmap preview;
+    QString previewName;
     QString charName;
 
     if (i == 0) {
-      preview.load(":/images/images/Dino_Start.png");
+      previewName = "Dino_Start";
       charName = "Normal";
     } else if (i == 1) {
-      preview.load(":/images/images/Hat_Start.png");
+      previewName = "Hat_Start";
       charName = "Yellow Hat";
     } else if (i == 2) {
-      preview.load(":/images/images/Santa_Start.png");
+      previewName = "Santa_Start";
       charName = "Santa";
     } else if (i == 3) {
-      preview.load(":/images/images/Cowboy_Start.png");
+      previewName = "Cowboy_Start";
       charName = "Cowboy";
     } else {
-      preview.load(":/images/images/Pirate_Start.png");
+      previewName = "Pirate_Start";
       charName = "Pirate";
     }
 
-    preview =
-        preview.scaled(50, 50, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPixmap preview =
+        QPixmap::fromImage(loadSprite(previewName, QSize(50, 50)));
     previewLabel->setPixmap(preview);
 
     // Name label
@@ -294,10 +292,8 @@ void MainWindow::openLeaderboard() {
   grid->setSpacing(10);
 
   QStringList names = {"Normal", "Yellow Hat", "Santa", "Cowboy", "Pirate"};
-  QStringList iconPaths = {
-      ":/images/images/Dino_Start.png", ":/images/images/Hat_Start.png",
-      ":/images/images/Santa_Start.png", ":/images/images/Cowboy_Start.png",
-      ":/images/images/Pirate_Start.png"};
+  QStringList iconNames = {"Dino_Start", "Hat_Start", "Santa_Start",
+                           "Cowboy_Start", "Pirate_Start"};
 
   QMap<int, int> scores = scoreManager->getTopScores();
 
@@ -318,8 +314,8 @@ void MainWindow::openLeaderboard() {
 
     // Icon
     QLabel *icon = new QLabel;
-    QPixmap pm(iconPaths[skinIdx]);
-    pm = pm.scaled(30, 30, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPixmap pm =
+        QPixmap::fromImage(loadSprite(iconNames[skinIdx], QSize(30, 30)));
     icon->setPixmap(pm);
     icon->setFixedSize(30, 30);
 
@@ -0,0 +1,183 @@
+#include "rgb565.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RGB565_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RGB565_NEON
+#endif
+
+namespace {
+
+// 4x4 Bayer matrix, thresholds 0-15
+const uint8_t BAYER[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+// d + (s - d) * a / 256 for each channel, a in [0, 256]. Stays within
+// [min(s, d), max(s, d)] per channel, so channels never carry into each
+// other.
+inline uint16_t blend(uint16_t s, uint16_t d, int a) {
+  int dr = d >> 11, dg = (d >> 5) & 63, db = d & 31;
+  int r = dr + ((((s >> 11) - dr) * a) >> 8);
+  int g = dg + (((((s >> 5) & 63) - dg) * a) >> 8);
+  int b = db + ((((s & 31) - db) * a) >> 8);
+  return uint16_t(r << 11 | g << 5 | b);
+}
+
+// 0-255 coverage to the 0-256 blend weight
+inline int weight(int alpha) { return alpha + (alpha >> 7); }
+
+void blendRow(uint16_t *dst, const uint16_t *src, const uint8_t *alpha,
+              int n) {
+  int i = 0;
+#if defined(RGB565_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i m63 = _mm_set1_epi16(63);
+  const __m128i m31 = _mm_set1_epi16(31);
+  for (; i + 8 <= n; i += 8) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+    __m128i a = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(alpha + i)), zero);
+    a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+
+    __m128i dr = _mm_srli_epi16(d, 11);
+    __m128i dg = _mm_and_si128(_mm_srli_epi16(d, 5), m63);
+    __m128i db = _mm_and_si128(d, m31);
+    __m128i r = _mm_sub_epi16(_mm_srli_epi16(s, 11), dr);
+    __m128i g = _mm_sub_epi16(_mm_and_si128(_mm_srli_epi16(s, 5), m63), dg);
+    __m128i b = _mm_sub_epi16(_mm_and_si128(s, m31), db);
+    r = _mm_add_epi16(dr, _mm_srai_epi16(_mm_mullo_epi16(r, a), 8));
+    g = _mm_add_epi16(dg, _mm_srai_epi16(_mm_mullo_epi16(g, a), 8));
+    b = _mm_add_epi16(db, _mm_srai_epi16(_mm_mullo_epi16(b, a), 8));
+
+    __m128i out = _mm_or_si128(
+        _mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), out);
+  }
+#elif defined(RGB565_NEON)
+  const int16x8_t m63 = vdupq_n_s16(63);
+  const int16x8_t m31 = vdupq_n_s16(31);
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t s = vreinterpretq_s16_u16(vld1q_u16(src + i));
+    int16x8_t d = vreinterpretq_s16_u16(vld1q_u16(dst + i));
+    uint16x8_t a8 = vmovl_u8(vld1_u8(alpha + i));
+    int16x8_t a = vreinterpretq_s16_u16(vaddq_u16(a8, vshrq_n_u16(a8, 7)));
+
+    // logical shifts: the top bit of a pixel is red, not a sign
+    int16x8_t dr = vreinterpretq_s16_u16(
+        vshrq_n_u16(vreinterpretq_u16_s16(d), 11));
+    int16x8_t dg = vandq_s16(vshrq_n_s16(d, 5), m63);
+    int16x8_t db = vandq_s16(d, m31);
+    int16x8_t sr = vreinterpretq_s16_u16(
+        vshrq_n_u16(vreinterpretq_u16_s16(s), 11));
+    int16x8_t sg = vandq_s16(vshrq_n_s16(s, 5), m63);
+    int16x8_t sb = vandq_s16(s, m31);
+    int16x8_t r = vmulq_s16(vsubq_s16(sr, dr), a);
+    int16x8_t g = vmulq_s16(vsubq_s16(sg, dg), a);
+    int16x8_t b = vmulq_s16(vsubq_s16(sb, db), a);
+    r = vaddq_s16(dr, vshrq_n_s16(r, 8));
+    g = vaddq_s16(dg, vshrq_n_s16(g, 8));
+    b = vaddq_s16(db, vshrq_n_s16(b, 8));
+
+    int16x8_t out =
+        vorrq_s16(vorrq_s16(vshlq_n_s16(r, 11), vshlq_n_s16(g, 5)), b);
+    vst1q_u16(dst + i, vreinterpretq_u16_s16(out));
+  }
+#endif
+  for (; i < n; ++i)
+    dst[i] = blend(src[i], dst[i], weight(alpha[i]));
+}
+
+} // namespace
+
+Sprite565 toSprite565(const uint32_t *argb, int width, int height, int stride,
+                      bool dither) {
+  Sprite565 s;
+  s.width = width;
+  s.height = height;
+  s.pixels.resize(size_t(width) * height);
+  s.alpha.resize(size_t(width) * height);
+  bool opaque = true;
+  for (int y = 0; y < height; ++y) {
+    const uint32_t *row = argb + size_t(y) * stride;
+    for (int x = 0; x < width; ++x) {
+      uint32_t px = row[x];
+      int a = px >> 24;
+      int r = (px >> 16) & 0xff;
+      int g = (px >> 8) & 0xff;
+      int b = px & 0xff;
+      if (dither) {
+        // spread the bits lost to 5 (6 for green) bit channels
+        int t = BAYER[y & 3][x & 3];
+        r = std::min(255, r + (t >> 1));
+        g = std::min(255, g + (t >> 2));
+        b = std::min(255, b + (t >> 1));
+      }
+      size_t i = size_t(y) * width + x;
+      s.pixels[i] = rgb565(r, g, b);
+      s.alpha[i] = uint8_t(a);
+      opaque = opaque && a == 255;
+    }
+  }
+  if (opaque)
+    s.alpha.clear();
+  return s;
+}
+
+void blit565(const Surface565 &dst, int x, int y, const Sprite565 &sprite,
+             int sx, int sy, int w, int h) {
+  // clip to the sprite, then to the surface
+  if (sx < 0) {
+    w += sx;
+    x -= sx;
+    sx = 0;
+  }
+  if (sy < 0) {
+    h += sy;
+    y -= sy;
+    sy = 0;
+  }
+  w = std::min(w, sprite.width - sx);
+  h = std::min(h, sprite.height - sy);
+  if (x < 0) {
+    w += x;
+    sx -= x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    sy -= y;
+    y = 0;
+  }
+  w = std::min(w, dst.width - x);
+  h = std::min(h, dst.height - y);
+  if (w <= 0 || h <= 0)
+    return;
+
+  for (int row = 0; row < h; ++row) {
+    uint16_t *d = dst.pixels + size_t(y + row) * dst.stride + x;
+    size_t at = size_t(sy + row) * sprite.width + sx;
+    if (sprite.isOpaque())
+      std::memcpy(d, &sprite.pixels[at], size_t(w) * sizeof(uint16_t));
+    else
+      blendRow(d, &sprite.pixels[at], &sprite.alpha[at], w);
+  }
+}
+
+const char *blit565Isa() {
+#if defined(RGB565_SSE2)
+  return "SSE2";
+#elif defined(RGB565_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
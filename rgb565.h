@@ -0,0 +1,52 @@
+#ifndef RGB565_H
+#define RGB565_H
+
+#include <cstdint>
+#include <vector>
+
+// RGB565 sprites and a compositor that draws them onto RGB565 surfaces (16
+// bpp framebuffers) in 16 bits, so frames never pass through 32-bit ARGB.
+// Sprites are converted once when loaded; coverage is kept beside the
+// pixels as one byte per pixel. The blend kernels use SSE2 or NEON when
+// the target has them and give the same pixels as the scalar code.
+
+struct Sprite565 {
+  int width = 0;
+  int height = 0;
+  std::vector<uint16_t> pixels; // width per row
+  std::vector<uint8_t> alpha;   // same layout, empty when fully opaque
+
+  bool isNull() const { return pixels.empty(); }
+  bool isOpaque() const { return alpha.empty(); }
+};
+
+// An RGB565 image owned elsewhere, stride in pixels
+struct Surface565 {
+  uint16_t *pixels;
+  int width;
+  int height;
+  int stride;
+};
+
+inline uint16_t rgb565(int r, int g, int b) {
+  return uint16_t((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+}
+
+// From non-premultiplied 0xAARRGGBB pixels, stride in pixels. With dither
+// the colours get a 4x4 ordered dither before losing their low bits, which
+// hides banding in smooth gradients (the night palette).
+Sprite565 toSprite565(const uint32_t *argb, int width, int height, int stride,
+                      bool dither);
+
+// Draws the part (sx, sy, w, h) of sprite at x, y, clipped to dst
+void blit565(const Surface565 &dst, int x, int y, const Sprite565 &sprite,
+             int sx, int sy, int w, int h);
+inline void blit565(const Surface565 &dst, int x, int y,
+                    const Sprite565 &sprite) {
+  blit565(dst, x, y, sprite, 0, 0, sprite.width, sprite.height);
+}
+
+// Kernel instruction set, "SSE2", "NEON" or "scalar"
+const char *blit565Isa();
+
+#endif // RGB565_H
@@ -0,0 +1,96 @@
+#include "scoreHud.h"
+#include <QFontMetrics>
+#include <QImage>
+
+namespace {
+
+int digitCount(int n) {
+  int digits = 1;
+  while (n >= 10) {
+    n /= 10;
+    ++digits;
+  }
+  return digits;
+}
+
+} // namespace
+
+void ScoreHud::build(const QFont &font, const QColor &day,
+                     const QColor &night) {
+  QFontMetrics fm(font);
+  digitW = 0;
+  for (char c = '0'; c <= '9'; ++c)
+    digitW = qMax(digitW, fm.horizontalAdvance(QLatin1Char(c)));
+  hiW = fm.horizontalAdvance(QStringLiteral("HI"));
+  spaceW = fm.horizontalAdvance(QLatin1Char(' '));
+  ascent = fm.ascent();
+  height = fm.height();
+
+  const int cellW = digitW + 2 * pad;
+  const QColor colors[2] = {day, night};
+  for (int i = 0; i < 2; ++i) {
+    QImage strip(10 * cellW + hiW + 2 * pad, height,
+                 QImage::Format_ARGB32_Premultiplied);
+    strip.fill(Qt::transparent);
+    QPainter p(&strip);
+    p.setFont(font);
+    p.setPen(colors[i]);
+    for (int d = 0; d < 10; ++d)
+      p.drawText(d * cellW + pad, ascent, QString(QChar('0' + d)));
+    p.drawText(10 * cellW + pad, ascent, QStringLiteral("HI"));
+    p.end();
+    themes[i] = Theme();
+    themes[i].strip = QPixmap::fromImage(strip);
+  }
+}
+
+int ScoreHud::lineWidth(int score, int highScore) const {
+  int width = qMax(5, digitCount(score)) * digitW;
+  if (highScore > 0)
+    width += hiW + spaceW + qMax(5, digitCount(highScore)) * digitW + spaceW;
+  return width;
+}
+
+// Blits cells from the strip: a cell drawn over the overhang of its
+// neighbour only adds its own coverage
+void ScoreHud::compose(Theme &t, int score, int highScore) {
+  const int cellW = digitW + 2 * pad;
+  QPixmap line(lineWidth(score, highScore) + 2 * pad, height);
+  line.fill(Qt::transparent);
+  QPainter p(&line);
+  int x = 0; // left of the current advance, less pad
+  auto number = [&](int n) {
+    int digits = qMax(5, digitCount(n));
+    for (int i = digits - 1; i >= 0; --i, n /= 10)
+      p.drawPixmap(x + i * digitW, 0, t.strip,
+                   (n % 10) * cellW, 0, cellW, height);
+    x += digits * digitW;
+  };
+  if (highScore > 0) {
+    p.drawPixmap(x, 0, t.strip, 10 * cellW, 0, hiW + 2 * pad, height);
+    x += hiW + spaceW;
+    number(highScore);
+    x += spaceW;
+  }
+  number(score);
+  p.end();
+
+  t.line = line;
+  t.score = score;
+  t.high = highScore;
+}
+
+void ScoreHud::draw(QPainter &p, int right, int baseline, int score,
+                    int highScore, bool night) {
+  Theme &t = themes[night ? 1 : 0];
+  if (t.strip.isNull())
+    return;
+  if (score != t.score || highScore != t.high)
+    compose(t, score, highScore);
+  p.drawPixmap(right - t.line.width() + pad, baseline - ascent, t.line);
+}
+
+QRect ScoreHud::bounds(int right, int baseline) const {
+  int width = lineWidth(0, 1) + 2 * pad;
+  return QRect(right - width + pad, baseline - ascent, width, height);
+}
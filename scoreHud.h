@@ -0,0 +1,46 @@
+#ifndef SCOREHUD_H
+#define SCOREHUD_H
+
+#include <QColor>
+#include <QFont>
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+
+// Score display without text layout in the frame loop. build() renders the
+// digits 0-9 and "HI" once per theme (day and night) into a strip of fixed
+// width cells; the score line is composed from those cells into a pixmap
+// only when the score or high score changes, and otherwise drawn as is.
+class ScoreHud {
+public:
+  void build(const QFont &font, const QColor &day, const QColor &night);
+
+  // Draws "HI <highScore> <score>", or only the score while highScore is
+  // 0, five digits at least, right-aligned to `right` on `baseline`
+  void draw(QPainter &p, int right, int baseline, int score, int highScore,
+            bool night);
+  // Area draw() covers with five digit scores and a high score
+  QRect bounds(int right, int baseline) const;
+
+private:
+  struct Theme {
+    QPixmap strip; // digit cells, then "HI"
+    QPixmap line;  // composed for score and high
+    int score = -1;
+    int high = -1;
+  };
+  void compose(Theme &t, int score, int highScore);
+  int lineWidth(int score, int highScore) const;
+
+  // glyphs can overhang their advance a little, cells keep pad pixels on
+  // both sides of it
+  static const int pad = 2;
+  Theme themes[2]; // day, night
+  int digitW = 0;  // advance of a digit
+  int hiW = 0;     // advance of "HI"
+  int spaceW = 0;
+  int ascent = 0;
+  int height = 0;
+};
+
+#endif // SCOREHUD_H
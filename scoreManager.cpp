@@ -1,4 +1,5 @@
 #include "scoreManager.h"
+#include "trace.h"
 #include <QDebug>
 #include <QFile>
 #include <QStringList>
@@ -7,6 +8,7 @@
 ScoreManager::ScoreManager() { loadScores(); }
 
 void ScoreManager::loadScores() {
+  TRACE_SCOPE("ScoreManager::loadScores");
   QFile file(filename);
   if (!file.exists()) {
     return; // File doesn't exist yet, skip loading
@@ -44,6 +46,7 @@ bool ScoreManager::saveScore(int skinIdx, int score) {
 }
 
 void ScoreManager::writeToFile() {
+  TRACE_SCOPE("ScoreManager::writeToFile");
   QFile file(filename);
   if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
     qDebug() << "Could not open scores file for writing:" << filename;
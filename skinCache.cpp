@@ -0,0 +1,201 @@
+#include "skinCache.h"
+#include "spriteBlob.h"
+#include "trace.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+namespace {
+
+struct SkinInfo {
+  const char *prefix;
+  QSize size;     // start, jump, dead and run frames
+  QSize duckSize; // duck frames
+};
+
+const SkinInfo SKINS[SkinCache::SKIN_COUNT] = {
+    {"Dino", QSize(36, 40), QSize(72, 25)},   // normal
+    {"Hat", QSize(38, 42), QSize(72, 28)},    // yellow hat
+    {"Santa", QSize(38, 42), QSize(72, 28)},  // santa
+    {"Cowboy", QSize(38, 42), QSize(72, 28)}, // cowboy
+    {"Pirate", QSize(38, 42), QSize(72, 28)}, // pirate
+};
+
+void loadFrames(QVector<QImage> &vec, const QString &baseName, int count,
+                const QSize &targetSize) {
+  for (int i = 0; i < count; ++i) {
+    QImage img = loadSprite(QString("%1_%2").arg(baseName).arg(i + 1),
+                            targetSize);
+    if (!img.isNull())
+      vec.push_back(img);
+  }
+}
+
+// Runs on a pool thread: only QImage is used here, QPixmap is GUI-thread only
+SkinImages decodeSkin(int skin) {
+  TRACE_SCOPE("SkinCache::decodeSkin");
+  QElapsedTimer timer;
+  timer.start();
+
+  const SkinInfo &info = SKINS[skin];
+  const QString base = QString("%1_").arg(info.prefix);
+
+  SkinImages images;
+  images.skin = skin;
+  images.start = loadSprite(base + "Start", info.size);
+  images.jump = loadSprite(base + "Jump", info.size);
+  images.dead = loadSprite(base + "Dead", info.size);
+  loadFrames(images.run, base + "Run", 2, info.size);
+  loadFrames(images.duck, base + "Duck", 2, info.duckSize);
+
+  auto masks = std::make_shared<DinoMasks>();
+  masks->start = spriteMask(images.start);
+  masks->jump = spriteMask(images.jump);
+  for (const auto &img : images.run)
+    masks->run.push_back(spriteMask(img));
+  for (const auto &img : images.duck)
+    masks->duck.push_back(spriteMask(img));
+  images.masks = masks;
+
+  images.decodeMs = timer.elapsed();
+  return images;
+}
+
+qint64 pixmapBytes(const QPixmap &pm) {
+  return qint64(pm.width()) * pm.height() * pm.depth() / 8;
+}
+
+} // namespace
+
+CollisionMask spriteMask(const QImage &sprite) {
+  const QImage img = sprite.convertToFormat(QImage::Format_ARGB32);
+  CollisionMask mask(img.width(), img.height());
+  for (int y = 0; y < img.height(); ++y) {
+    const QRgb *line = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+    for (int x = 0; x < img.width(); ++x) {
+      if (qAlpha(line[x]) >= 128)
+        mask.set(x, y);
+    }
+  }
+  return mask;
+}
+
+qint64 SkinSprites::byteSize() const {
+  qint64 bytes = pixmapBytes(start) + pixmapBytes(jump) + pixmapBytes(dead);
+  for (const auto &pm : run)
+    bytes += pixmapBytes(pm);
+  for (const auto &pm : duck)
+    bytes += pixmapBytes(pm);
+  return bytes + pixmapBytes(atlas.pixmap());
+}
+
+SkinCache::SkinCache(QObject *parent)
+    : QObject(parent), sets(SKIN_COUNT), watchers(SKIN_COUNT, nullptr),
+      lastUsed(SKIN_COUNT, 0) {}
+
+SkinCache::~SkinCache() {
+  // pool threads must not outlive the watchers
+  for (auto *watcher : std::as_const(watchers)) {
+    if (watcher)
+      watcher->waitForFinished();
+  }
+}
+
+void SkinCache::preloadAll() {
+  for (int skin = 0; skin < SKIN_COUNT; ++skin) {
+    if (sets[skin] || watchers[skin])
+      continue;
+
+    auto *watcher = new QFutureWatcher<SkinImages>(this);
+    watchers[skin] = watcher;
+    connect(watcher, &QFutureWatcher<SkinImages>::finished, this,
+            [this, watcher, skin]() {
+              // get() may already have collected the result
+              if (watchers[skin] == watcher) {
+                watchers[skin] = nullptr;
+                store(watcher->result());
+              }
+              watcher->deleteLater();
+            });
+    watcher->setFuture(QtConcurrent::run(decodeSkin, skin));
+  }
+}
+
+QSharedPointer<const SkinSprites> SkinCache::get(int skin) {
+  if (skin < 0 || skin >= SKIN_COUNT)
+    return {};
+
+  if (!sets[skin]) {
+    if (QFutureWatcher<SkinImages> *watcher = watchers[skin]) {
+      watcher->waitForFinished();
+      watchers[skin] = nullptr;
+      store(watcher->result());
+    } else {
+      store(decodeSkin(skin));
+    }
+  }
+
+  lastUsed[skin] = ++useCounter;
+  return sets[skin];
+}
+
+void SkinCache::setMemoryLimit(qint64 bytes) {
+  memoryLimit = bytes;
+  evict(-1);
+}
+
+qint64 SkinCache::memoryUsage() const {
+  qint64 bytes = 0;
+  for (const auto &set : sets) {
+    if (set)
+      bytes += set->byteSize();
+  }
+  return bytes;
+}
+
+void SkinCache::store(const SkinImages &images) {
+  TRACE_SCOPE("SkinCache::store");
+  auto set = QSharedPointer<SkinSprites>::create();
+  set->start = QPixmap::fromImage(images.start);
+  set->jump = QPixmap::fromImage(images.jump);
+  set->dead = QPixmap::fromImage(images.dead);
+  for (const auto &img : images.run)
+    set->run.push_back(QPixmap::fromImage(img));
+  for (const auto &img : images.duck)
+    set->duck.push_back(QPixmap::fromImage(img));
+
+  QVector<QPixmap> sprites;
+  sprites << set->start << set->jump << set->dead << set->run << set->duck;
+  set->atlas.build(sprites);
+  set->masks = images.masks;
+
+  sets[images.skin] = set;
+  if (!lastUsed[images.skin])
+    lastUsed[images.skin] = ++useCounter;
+
+#ifdef LOAD_STATS
+  qDebug() << "skin" << images.skin << "decoded in" << images.decodeMs
+           << "ms, cache" << memoryUsage() / 1024 << "KiB";
+#endif
+
+  evict(images.skin);
+  emit skinReady(images.skin);
+}
+
+// Drops least recently used skins (never `keep`) until under the limit.
+// Skins in use stay alive through their shared pointer.
+void SkinCache::evict(int keep) {
+  while (memoryUsage() > memoryLimit) {
+    int victim = -1;
+    for (int skin = 0; skin < SKIN_COUNT; ++skin) {
+      if (!sets[skin] || skin == keep)
+        continue;
+      if (victim < 0 || lastUsed[skin] < lastUsed[victim])
+        victim = skin;
+    }
+    if (victim < 0)
+      return;
+    sets[victim].reset();
+    lastUsed[victim] = 0;
+  }
+}
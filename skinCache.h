@@ -0,0 +1,82 @@
+#ifndef SKINCACHE_H
+#define SKINCACHE_H
+
+#include "gameState.h"
+#include "spriteAtlas.h"
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QVector>
+#include <memory>
+
+// Log skin decode times and time to first frame after a skin switch
+// #define LOAD_STATS
+
+// Decoded and scaled sprites of one skin, as produced off the GUI thread
+struct SkinImages {
+  int skin = -1;
+  QImage start;
+  QImage jump;
+  QImage dead;
+  QVector<QImage> run;
+  QVector<QImage> duck;
+  std::shared_ptr<const DinoMasks> masks;
+  qint64 decodeMs = 0;
+};
+
+// Ready-to-draw sprites of one skin, with its own atlas
+struct SkinSprites {
+  QPixmap start;
+  QPixmap jump;
+  QPixmap dead;
+  QVector<QPixmap> run;
+  QVector<QPixmap> duck;
+  SpriteAtlas atlas;
+  std::shared_ptr<const DinoMasks> masks; // collision masks of the frames
+
+  qint64 byteSize() const;
+};
+
+// Collision mask of a sprite: pixels at least half opaque are solid
+CollisionMask spriteMask(const QImage &sprite);
+
+// Decodes and scales every skin on the thread pool at startup and hands the
+// finished sprite sets to the GUI thread. Sets are shared and immutable, so
+// switching skins is a pointer swap. When the cache grows over its memory
+// limit the least recently used skins are dropped and decoded again on
+// demand.
+class SkinCache : public QObject {
+  Q_OBJECT
+public:
+  static const int SKIN_COUNT = 5;
+
+  explicit SkinCache(QObject *parent = nullptr);
+  ~SkinCache();
+
+  // Starts background decoding of every skin that is not cached yet
+  void preloadAll();
+
+  // Returns the sprites for a skin, waiting for (or doing) the decode if it
+  // has not finished yet
+  QSharedPointer<const SkinSprites> get(int skin);
+
+  void setMemoryLimit(qint64 bytes);
+  qint64 memoryUsage() const;
+
+signals:
+  void skinReady(int skin);
+
+private:
+  void store(const SkinImages &images);
+  void evict(int keep);
+
+  QVector<QSharedPointer<const SkinSprites>> sets;
+  QVector<QFutureWatcher<SkinImages> *> watchers;
+  QVector<quint64> lastUsed;
+  quint64 useCounter = 0;
+  qint64 memoryLimit = 4 * 1024 * 1024;
+};
+
+#endif // SKINCACHE_H
@@ -0,0 +1,124 @@
+#include "spriteAtlas.h"
+#include <QImage>
+#include <algorithm>
+
+namespace {
+const int ATLAS_MIN_WIDTH = 256;
+const int ATLAS_PADDING = 1;
+} // namespace
+
+void SpriteAtlas::build(const QVector<QPixmap> &sprites) {
+  clear();
+
+  // unique, non-null sprites sorted by height for shelf packing
+  QVector<QPixmap> order;
+  for (const auto &pm : sprites) {
+    if (pm.isNull() || rects.contains(pm.cacheKey()))
+      continue;
+    rects.insert(pm.cacheKey(), QRect());
+    order.push_back(pm);
+  }
+  if (order.isEmpty())
+    return;
+
+  std::stable_sort(order.begin(), order.end(),
+                   [](const QPixmap &a, const QPixmap &b) {
+                     return a.height() > b.height();
+                   });
+
+  int sheetW = ATLAS_MIN_WIDTH;
+  for (const auto &pm : std::as_const(order))
+    sheetW = std::max(sheetW, pm.width() + ATLAS_PADDING);
+
+  int x = 0;
+  int y = 0;
+  int shelfH = 0;
+  for (const auto &pm : std::as_const(order)) {
+    if (x + pm.width() > sheetW) {
+      x = 0;
+      y += shelfH + ATLAS_PADDING;
+      shelfH = 0;
+    }
+    rects[pm.cacheKey()] = QRect(x, y, pm.width(), pm.height());
+    x += pm.width() + ATLAS_PADDING;
+    shelfH = std::max(shelfH, pm.height());
+  }
+
+  QImage img(sheetW, y + shelfH, QImage::Format_ARGB32_Premultiplied);
+  img.fill(Qt::transparent);
+  QPainter painter(&img);
+  painter.setCompositionMode(QPainter::CompositionMode_Source);
+  for (const auto &pm : std::as_const(order))
+    painter.drawPixmap(rects.value(pm.cacheKey()).topLeft(), pm);
+  painter.end();
+
+  sheet = QPixmap::fromImage(img);
+}
+
+void SpriteAtlas::clear() {
+  sheet = QPixmap();
+  rects.clear();
+}
+
+bool SpriteAtlas::contains(const QPixmap &pm) const {
+  return !sheet.isNull() && rects.contains(pm.cacheKey());
+}
+
+QRect SpriteAtlas::sourceRect(const QPixmap &pm) const {
+  return rects.value(pm.cacheKey());
+}
+
+SpriteBatch::SpriteBatch(QPainter &painter, const SpriteAtlas &spriteAtlas)
+    : p(painter) {
+  addAtlas(spriteAtlas);
+}
+
+SpriteBatch::~SpriteBatch() { flush(); }
+
+void SpriteBatch::addAtlas(const SpriteAtlas &spriteAtlas) {
+  atlases.push_back(&spriteAtlas);
+}
+
+const SpriteAtlas *SpriteBatch::findAtlas(const QPixmap &pm) const {
+  for (const SpriteAtlas *atlas : atlases) {
+    if (atlas->contains(pm))
+      return atlas;
+  }
+  return nullptr;
+}
+
+void SpriteBatch::draw(int x, int y, const QPixmap &pm) {
+  draw(x, y, pm, pm.rect());
+}
+
+void SpriteBatch::draw(int x, int y, const QPixmap &pm, const QRect &src) {
+  if (pm.isNull() || src.isEmpty())
+    return;
+  ++sprites;
+
+  const SpriteAtlas *atlas = findAtlas(pm);
+  if (!atlas) {
+    flush();
+    p.drawPixmap(QPoint(x, y), pm, src);
+    ++drawCalls;
+    return;
+  }
+  if (atlas != pending) {
+    flush();
+    pending = atlas;
+  }
+
+  // fragment positions are the center of the target rect
+  QRect sheetSrc = src.translated(atlas->sourceRect(pm).topLeft());
+  fragments.push_back(QPainter::PixmapFragment::create(
+      QPointF(x + src.width() / 2.0, y + src.height() / 2.0), sheetSrc));
+}
+
+void SpriteBatch::flush() {
+  if (fragments.isEmpty())
+    return;
+  p.drawPixmapFragments(fragments.constData(), fragments.size(),
+                        pending->pixmap());
+  ++drawCalls;
+  fragments.clear();
+}
@@ -0,0 +1,64 @@
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include <QHash>
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+#include <QVector>
+
+// Packs a set of sprites into one sheet so they can be drawn as sub-rects of
+// a single pixmap. Sprites are looked up by QPixmap::cacheKey(), so callers
+// keep using their own QPixmap members and copies of them.
+class SpriteAtlas {
+public:
+  // Packs the given sprites (shelf packing, tallest first)
+  void build(const QVector<QPixmap> &sprites);
+  void clear();
+
+  bool contains(const QPixmap &pm) const;
+  QRect sourceRect(const QPixmap &pm) const;
+  const QPixmap &pixmap() const { return sheet; }
+  bool isNull() const { return sheet.isNull(); }
+
+private:
+  QPixmap sheet;
+  QHash<qint64, QRect> rects;
+};
+
+// Collects sprite draws for one frame and submits each run of sprites from
+// the same atlas with a single QPainter::drawPixmapFragments call. Sprites
+// that are in none of the atlases are drawn directly, after flushing what was
+// queued so far to keep the painting order.
+class SpriteBatch {
+public:
+  SpriteBatch(QPainter &painter, const SpriteAtlas &spriteAtlas);
+  ~SpriteBatch();
+
+  // Additional atlas to look sprites up in
+  void addAtlas(const SpriteAtlas &spriteAtlas);
+
+  void draw(int x, int y, const QPixmap &pm);
+  // draws only the part of pm given by src (in pm coordinates) at x, y
+  void draw(int x, int y, const QPixmap &pm, const QRect &src);
+  void draw(const QPoint &pos, const QPixmap &pm) {
+    draw(pos.x(), pos.y(), pm);
+  }
+  void flush();
+
+  // Per-frame statistics
+  int spriteCount() const { return sprites; }
+  int drawCallCount() const { return drawCalls; }
+
+private:
+  const SpriteAtlas *findAtlas(const QPixmap &pm) const;
+
+  QPainter &p;
+  QVector<const SpriteAtlas *> atlases;
+  const SpriteAtlas *pending = nullptr;
+  QVector<QPainter::PixmapFragment> fragments;
+  int sprites = 0;
+  int drawCalls = 0;
+};
+
+#endif // SPRITEATLAS_H
@@ -0,0 +1,40 @@
+#include "spriteBatch565.h"
+
+void Sprite565Cache::add(const QPixmap &pm, bool dither) {
+  if (pm.isNull())
+    return;
+  QImage img = pm.toImage().convertToFormat(QImage::Format_ARGB32);
+  sprites.insert(pm.cacheKey(),
+                 toSprite565(reinterpret_cast<const uint32_t *>(img.bits()),
+                             img.width(), img.height(),
+                             img.bytesPerLine() / 4, dither));
+}
+
+const Sprite565 &Sprite565Cache::get(const QPixmap &pm) {
+  auto it = sprites.find(pm.cacheKey());
+  if (it == sprites.end()) {
+    add(pm);
+    it = sprites.find(pm.cacheKey());
+  }
+  return *it;
+}
+
+SpriteBatch565::SpriteBatch565(QImage &target, Sprite565Cache &cache)
+    : surface{reinterpret_cast<uint16_t *>(target.bits()), target.width(),
+              target.height(), int(target.bytesPerLine() / 2)},
+      cache(cache) {}
+
+void SpriteBatch565::draw(int x, int y, const QPixmap &pm) {
+  if (pm.isNull())
+    return;
+  blit565(surface, x, y, cache.get(pm));
+  ++sprites;
+}
+
+void SpriteBatch565::draw(int x, int y, const QPixmap &pm, const QRect &src) {
+  if (pm.isNull())
+    return;
+  blit565(surface, x, y, cache.get(pm), src.x(), src.y(), src.width(),
+          src.height());
+  ++sprites;
+}
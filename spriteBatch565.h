@@ -0,0 +1,50 @@
+#ifndef SPRITEBATCH565_H
+#define SPRITEBATCH565_H
+
+#include "rgb565.h"
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QPoint>
+#include <QRect>
+
+// RGB565 copies of sprites, converted once per pixmap and looked up by
+// QPixmap::cacheKey() like SpriteAtlas
+class Sprite565Cache {
+public:
+  // Converts pm now, with ordered dithering if asked (see toSprite565)
+  void add(const QPixmap &pm, bool dither = false);
+  // The copy of pm, converted without dithering on first use
+  const Sprite565 &get(const QPixmap &pm);
+  void clear() { sprites.clear(); }
+
+private:
+  QHash<qint64, Sprite565> sprites;
+};
+
+// Same drawing calls as SpriteBatch, but composited in 16 bits straight
+// into an RGB565 image (QImage::Format_RGB16) with blit565()
+class SpriteBatch565 {
+public:
+  SpriteBatch565(QImage &target, Sprite565Cache &cache);
+
+  void draw(int x, int y, const QPixmap &pm);
+  // draws only the part of pm given by src (in pm coordinates) at x, y
+  void draw(int x, int y, const QPixmap &pm, const QRect &src);
+  void draw(const QPoint &pos, const QPixmap &pm) {
+    draw(pos.x(), pos.y(), pm);
+  }
+  // Every draw is done at once, nothing to submit
+  void flush() {}
+
+  // Per-frame statistics
+  int spriteCount() const { return sprites; }
+  int drawCallCount() const { return sprites; }
+
+private:
+  Surface565 surface;
+  Sprite565Cache &cache;
+  int sprites = 0;
+};
+
+#endif // SPRITEBATCH565_H
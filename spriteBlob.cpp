@@ -0,0 +1,75 @@
+#include "spriteBlob.h"
+#include <QCoreApplication>
+#include <QDebug>
+
+using namespace SpriteBlobFormat;
+
+SpriteBlob::SpriteBlob(const QString &path) : file(path) {
+  if (!file.exists() || !file.open(QIODevice::ReadOnly))
+    return;
+
+  const qint64 size = file.size();
+  if (size < qint64(sizeof(Header)))
+    return;
+  const uchar *map = file.map(0, size);
+  if (!map) {
+    qDebug() << "Could not map sprite blob:" << path;
+    return;
+  }
+
+  const auto *header = reinterpret_cast<const Header *>(map);
+  if (header->magic != MAGIC || header->version != VERSION ||
+      qint64(sizeof(Header) + header->count * sizeof(Entry)) > size) {
+    qDebug() << "Ignoring invalid sprite blob:" << path;
+    file.unmap(const_cast<uchar *>(map));
+    return;
+  }
+
+  const auto *entries = reinterpret_cast<const Entry *>(header + 1);
+  for (quint32 i = 0; i < header->count; ++i) {
+    const Entry &e = entries[i];
+    if (qint64(e.offset) + qint64(e.bytesPerLine) * e.height > size)
+      continue;
+    index.insert(QString::fromLatin1(e.name, qstrnlen(e.name, NAME_SIZE)),
+                 &e);
+  }
+  data = map;
+}
+
+QImage SpriteBlob::image(const QString &key) const {
+  const Entry *e = index.value(key, nullptr);
+  if (!e)
+    return QImage();
+  // const data: the image shares the mapping and detaches on write
+  return QImage(data + e->offset, e->width, e->height, e->bytesPerLine,
+                QImage::Format_ARGB32_Premultiplied);
+}
+
+QString spriteKey(const QString &name, const QSize &box) {
+  return QString("%1@%2x%3").arg(name).arg(box.width()).arg(box.height());
+}
+
+QImage scaleSprite(const QImage &src, const QSize &box) {
+  QImage scaled =
+      box.width() == 0
+          ? src.scaledToHeight(box.height(), Qt::SmoothTransformation)
+          : src.scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  return scaled.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+QImage loadSprite(const QString &name, const QSize &box) {
+  // opened on first use, thread-safe static initialization
+  static const SpriteBlob blob(QCoreApplication::applicationDirPath() +
+                               "/sprites.bin");
+
+  if (blob.isOpen()) {
+    QImage img = blob.image(spriteKey(name, box));
+    if (!img.isNull())
+      return img;
+  }
+
+  QImage img(QString(":/images/images/%1.png").arg(name));
+  if (img.isNull())
+    return img;
+  return scaleSprite(img, box);
+}
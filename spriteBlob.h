@@ -0,0 +1,63 @@
+#ifndef SPRITEBLOB_H
+#define SPRITEBLOB_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// On-disk layout of sprites.bin, written by tools/spriteBake. All fields are
+// native endian. Pixels are premultiplied ARGB32, each sprite starting at a
+// 16 byte aligned offset from the start of the file.
+namespace SpriteBlobFormat {
+const quint32 MAGIC = 0x52505344; // "DSPR"
+const quint32 VERSION = 1;
+const int NAME_SIZE = 48;
+
+struct Header {
+  quint32 magic;
+  quint32 version;
+  quint32 count; // number of Entry records following the header
+  quint32 reserved;
+};
+
+struct Entry {
+  char name[NAME_SIZE]; // spriteKey(), NUL terminated
+  quint32 width;
+  quint32 height;
+  quint32 bytesPerLine;
+  quint32 offset;
+};
+} // namespace SpriteBlobFormat
+
+// Read-only view of a baked sprite blob. The file is memory mapped and the
+// returned images point straight into the mapping, so nothing is decoded or
+// copied until the image is modified or turned into a pixmap.
+class SpriteBlob {
+public:
+  explicit SpriteBlob(const QString &path);
+
+  bool isOpen() const { return data != nullptr; }
+  // Null image if the blob has no sprite with this key
+  QImage image(const QString &key) const;
+
+private:
+  QFile file;
+  const uchar *data = nullptr;
+  QHash<QString, const SpriteBlobFormat::Entry *> index;
+};
+
+// Key of a sprite scaled to fit box, e.g. "Bird1@42x27". A box width of 0
+// means "scale to the box height".
+QString spriteKey(const QString &name, const QSize &box);
+
+// Scales a decoded image the way the game expects (smooth, keep aspect ratio)
+QImage scaleSprite(const QImage &src, const QSize &box);
+
+// Returns images/<name>.png scaled to box, from sprites.bin next to the
+// executable when it has the sprite, otherwise decoded from the resources.
+// Safe to call from any thread.
+QImage loadSprite(const QString &name, const QSize &box);
+
+#endif // SPRITEBLOB_H
@@ -0,0 +1,17 @@
+# Monte Carlo balance evaluator: plays many headless games with scripted
+# bots on all cores and reports score and death-cause distributions
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= qt app_bundle
+
+TARGET = dinoBalance
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    workStealing.h
+
+include(../../gameCore/gameCore.pri)
+
+LIBS += -lpthread
@@ -0,0 +1,392 @@
+// Monte Carlo balance evaluator: plays many headless games with a scripted
+// bot across all cores and prints the score distribution and what killed
+// the dino, for the given game parameters.
+//
+// usage: dinoBalance [--games N] [--threads N] [--bot perfect|reaction|random]
+//                    [--reaction-ms MS] [--seed N] [--max-minutes M]
+//                    [--bucket POINTS] [--<GameConfig field> VALUE ...]
+//
+// Game i is played with seed (seed + i), so results do not depend on the
+// number of threads. Headless games have no sprite masks, hits use the box
+// overlap rule (GameConfig::minOverlap).
+#include "gameState.h"
+#include "workStealing.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const float STEP = 1.f / 120.f;
+
+enum DeathCause {
+  DEATH_LARGE_CACTUS,
+  DEATH_SMALL_CACTUS,
+  DEATH_LOW_BIRD,
+  DEATH_MID_BIRD,
+  DEATH_HIGH_BIRD,
+  SURVIVED, // reached the time limit
+  CAUSE_COUNT
+};
+
+const char *CAUSE_NAMES[CAUSE_COUNT] = {"large cactus", "small cactus",
+                                       "low bird",     "mid bird",
+                                       "high bird",    "survived"};
+
+struct Options {
+  GameConfig cfg;
+  uint32_t games = 10000;
+  int threads = 0; // 0: all cores
+  std::string bot = "reaction";
+  float reactionMs = 200.f;
+  uint32_t seed = 1;
+  float maxMinutes = 10.f;
+  int bucket = 100;
+};
+
+// Decides the input of each step. One bot per game, used by one thread.
+class Bot {
+public:
+  virtual ~Bot() {}
+  virtual GameInput decide(const GameState &g, uint32_t step) = 0;
+};
+
+// Oracle: plays ahead on copies of the game, which spawn exactly the same
+// obstacles, and picks the first action the dino survives for `horizon`
+// steps afterwards without further input.
+class PerfectBot : public Bot {
+public:
+  GameInput decide(const GameState &g, uint32_t step) override {
+    if (step < safeUntil)
+      return GameInput();
+
+    GameInput none, jump, duck, release;
+    jump.jumpPressed = true;
+    duck.duckPressed = true;
+    release.duckReleased = true;
+
+    // standing is preferred, duck only while needed
+    const GameInput *order[4];
+    int n = 0;
+    if (g.isCrouching)
+      order[n++] = &release;
+    order[n++] = &none;
+    if (g.onGround)
+      order[n++] = &jump;
+    if (!g.isCrouching)
+      order[n++] = &duck;
+
+    for (int i = 0; i < n; ++i) {
+      if (survives(g, *order[i])) {
+        safeUntil = step + HORIZON / 2;
+        return *order[i];
+      }
+    }
+    return none; // nothing helps
+  }
+
+private:
+  static const uint32_t HORIZON = 90; // longer than a jump
+
+  static bool survives(const GameState &g, const GameInput &input) {
+    GameState future = g;
+    future.step(input, STEP);
+    for (uint32_t i = 0; i < HORIZON && !future.gameOver; ++i)
+      future.step(GameInput(), STEP);
+    return !future.gameOver;
+  }
+
+  uint32_t safeUntil = 0;
+};
+
+// Reacts to what is on screen like a player: jumps when a cactus gets close
+// and ducks under birds low enough to hit, aiming for the average reaction
+// time, but every action lands after a jittered delay.
+class ReactionBot : public Bot {
+public:
+  ReactionBot(float reactionMs, uint32_t seed)
+      : rng(seed), reaction(reactionMs / 1000.f / STEP) {}
+
+  GameInput decide(const GameState &g, uint32_t step) override {
+    const GameConfig &cfg = g.config();
+    const float lead = g.speed * (reaction + LEAD_STEPS) * STEP;
+
+    GameInput intent;
+    for (const GameRect &c : g.cactus) {
+      float gap = c.x - g.dino.right();
+      if (gap >= 0.f && gap < lead && step >= busyUntil) {
+        intent.jumpPressed = true;
+        busyUntil = step + uint32_t(2 * -cfg.jumpV / cfg.gravity / STEP);
+      }
+    }
+    bool birdAhead = false;
+    for (const GameRect &b : g.birds) {
+      float gap = b.x - g.dino.right();
+      bool low = b.bottom() > cfg.groundY - cfg.dinoH;
+      birdAhead |= low && gap < lead * cfg.birdSpeedFactor &&
+                   b.right() > g.dino.x;
+    }
+    if (birdAhead && !ducking)
+      intent.duckPressed = ducking = true;
+    else if (!birdAhead && ducking) {
+      intent.duckReleased = true;
+      ducking = false;
+    }
+
+    // jitter of up to half the reaction time on top of it
+    float delay = std::min(float(PENDING - 1), reaction * (1.f + jitter(rng)));
+    GameInput &later = pending[(step + uint32_t(delay)) % PENDING];
+    later.jumpPressed |= intent.jumpPressed;
+    later.duckPressed |= intent.duckPressed;
+    later.duckReleased |= intent.duckReleased;
+
+    GameInput now = pending[step % PENDING];
+    pending[step % PENDING] = GameInput();
+    return now;
+  }
+
+private:
+  static const uint32_t PENDING = 512; // longest delay, in steps
+  static constexpr float LEAD_STEPS = 6.f;
+
+  std::mt19937 rng;
+  std::uniform_real_distribution<float> jitter{0.f, 0.5f};
+  float reaction; // in steps
+  uint32_t busyUntil = 0;
+  bool ducking = false;
+  GameInput pending[PENDING];
+};
+
+// Mashes keys: about one jump a second, ducks now and then
+class RandomBot : public Bot {
+public:
+  explicit RandomBot(uint32_t seed) : rng(seed) {}
+
+  GameInput decide(const GameState &g, uint32_t) override {
+    GameInput input;
+    input.jumpPressed = chance(rng) < 1.f / 120.f;
+    if (chance(rng) < 1.f / 240.f) {
+      input.duckPressed = !g.isCrouching;
+      input.duckReleased = g.isCrouching;
+    }
+    return input;
+  }
+
+private:
+  std::mt19937 rng;
+  std::uniform_real_distribution<float> chance{0.f, 1.f};
+};
+
+std::unique_ptr<Bot> makeBot(const Options &opt, uint32_t seed) {
+  if (opt.bot == "perfect")
+    return std::unique_ptr<Bot>(new PerfectBot());
+  if (opt.bot == "random")
+    return std::unique_ptr<Bot>(new RandomBot(seed ^ 0x9e3779b9u));
+  return std::unique_ptr<Bot>(
+      new ReactionBot(opt.reactionMs, seed ^ 0x9e3779b9u));
+}
+
+// The obstacle overlapping the dino the most, or the nearest one when the
+// hit was found by the sweep and they have moved apart since
+DeathCause deathCause(const GameState &g) {
+  const GameConfig &cfg = g.config();
+  float best = -1.f;
+  float nearest = 1e9f;
+  DeathCause cause = DEATH_SMALL_CACTUS;
+  auto consider = [&](const GameRect &r, DeathCause c) {
+    float overlap = g.dino.overlapArea(r);
+    float distance = std::fabs(r.x - g.dino.x);
+    bool closer = best <= 0.f && overlap <= 0.f && distance < nearest;
+    if (overlap > best || closer) {
+      best = overlap;
+      nearest = distance;
+      cause = c;
+    }
+  };
+  for (int i = 0; i < g.cactus.size(); ++i)
+    consider(g.cactus[i],
+             g.cactus.type(i) < 3 ? DEATH_LARGE_CACTUS : DEATH_SMALL_CACTUS);
+  for (const GameRect &b : g.birds) {
+    float height = cfg.groundY - b.y;
+    consider(b, height <= 75.f    ? DEATH_LOW_BIRD
+                : height <= 105.f ? DEATH_MID_BIRD
+                                  : DEATH_HIGH_BIRD);
+  }
+  return cause;
+}
+
+// Per-thread results, merged once all games are done
+struct alignas(64) WorkerStats {
+  uint64_t games = 0;
+  uint64_t steps = 0;
+  uint64_t causes[CAUSE_COUNT] = {};
+};
+
+void playGames(const Options &opt, WorkStealingRanges &work, int worker,
+               std::vector<int> &scores, WorkerStats &stats) {
+  const uint32_t maxSteps = uint32_t(opt.maxMinutes * 60.f / STEP);
+  GameState g(opt.cfg);
+  uint32_t item;
+  while (work.next(worker, item)) {
+    uint32_t seed = opt.seed + item;
+    g.reset(seed);
+    std::unique_ptr<Bot> bot = makeBot(opt, seed);
+
+    GameInput start;
+    start.jumpPressed = true;
+    g.step(start, STEP);
+    uint32_t step = 1;
+    while (!g.gameOver && step < maxSteps) {
+      g.step(bot->decide(g, step), STEP);
+      ++step;
+    }
+
+    scores[item] = g.score; // each item is written by one thread only
+    stats.games++;
+    stats.steps += step;
+    stats.causes[g.gameOver ? deathCause(g) : SURVIVED]++;
+  }
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: dinoBalance [--games N] [--threads N]\n"
+               "                   [--bot perfect|reaction|random]\n"
+               "                   [--reaction-ms MS] [--seed N]\n"
+               "                   [--max-minutes M] [--bucket POINTS]\n"
+               "                   [--base-speed V] [--max-speed V]\n"
+               "                   [--speed-step V] [--spawn-min S]\n"
+               "                   [--spawn-max S] [--min-gap S]\n"
+               "                   [--bird-chance P]\n");
+}
+
+bool parse(int argc, char **argv, Options &opt) {
+  struct FloatArg {
+    const char *name;
+    float *value;
+  } floats[] = {
+      {"--reaction-ms", &opt.reactionMs}, {"--max-minutes", &opt.maxMinutes},
+      {"--base-speed", &opt.cfg.baseSpeed}, {"--max-speed", &opt.cfg.maxSpeed},
+      {"--speed-step", &opt.cfg.speedStep}, {"--spawn-min", &opt.cfg.spawnMin},
+      {"--spawn-max", &opt.cfg.spawnMax},   {"--min-gap", &opt.cfg.minGap},
+      {"--bird-chance", &opt.cfg.birdChance},
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const char *value = argv[++i];
+
+    bool found = false;
+    for (const FloatArg &f : floats) {
+      if (arg == f.name) {
+        *f.value = std::strtof(value, nullptr);
+        found = true;
+      }
+    }
+    if (found)
+      continue;
+    if (arg == "--games")
+      opt.games = std::strtoul(value, nullptr, 10);
+    else if (arg == "--threads")
+      opt.threads = std::atoi(value);
+    else if (arg == "--seed")
+      opt.seed = std::strtoul(value, nullptr, 10);
+    else if (arg == "--bucket")
+      opt.bucket = std::max(1, std::atoi(value));
+    else if (arg == "--bot")
+      opt.bot = value;
+    else
+      return false;
+  }
+  return opt.bot == "perfect" || opt.bot == "reaction" || opt.bot == "random";
+}
+
+void report(const Options &opt, const std::vector<int> &scores,
+            const WorkerStats &total, double seconds, int threads) {
+  std::vector<int> sorted = scores;
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0.0;
+  for (int s : sorted)
+    sum += s;
+  auto percentile = [&](double p) {
+    return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+  };
+
+  std::printf("bot %s, %u games on %d threads in %.2f s (%.0f games/s, "
+              "%.3g steps/s)\n",
+              opt.bot.c_str(), opt.games, threads, seconds,
+              opt.games / seconds, total.steps / seconds);
+  std::printf("score mean %.1f  p10 %d  p50 %d  p90 %d  p99 %d  max %d\n\n",
+              sum / sorted.size(), percentile(0.10), percentile(0.50),
+              percentile(0.90), percentile(0.99), sorted.back());
+
+  std::printf("score histogram\n");
+  int buckets = sorted.back() / opt.bucket + 1;
+  std::vector<uint32_t> hist(buckets, 0);
+  for (int s : sorted)
+    hist[s / opt.bucket]++;
+  uint32_t peak = *std::max_element(hist.begin(), hist.end());
+  for (int b = 0; b < buckets; ++b) {
+    if (!hist[b])
+      continue;
+    int bar = int(50.0 * hist[b] / peak + 0.5);
+    std::printf("  %6d-%-6d %7u %5.1f%% %s\n", b * opt.bucket,
+                (b + 1) * opt.bucket - 1, hist[b], 100.0 * hist[b] / opt.games,
+                std::string(bar, '#').c_str());
+  }
+
+  std::printf("\ndeath causes\n");
+  for (int c = 0; c < CAUSE_COUNT; ++c) {
+    std::printf("  %-13s %7llu %5.1f%%\n", CAUSE_NAMES[c],
+                (unsigned long long)total.causes[c],
+                100.0 * total.causes[c] / opt.games);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parse(argc, argv, opt) || opt.games == 0) {
+    usage();
+    return 1;
+  }
+
+  int threads = opt.threads > 0 ? opt.threads
+                                : int(std::thread::hardware_concurrency());
+  threads = std::max(1, std::min<int>(threads, opt.games));
+
+  WorkStealingRanges work(opt.games, threads);
+  std::vector<int> scores(opt.games, 0);
+  std::vector<WorkerStats> stats(threads);
+
+  auto started = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t)
+    pool.emplace_back(playGames, std::cref(opt), std::ref(work), t,
+                      std::ref(scores), std::ref(stats[t]));
+  for (std::thread &t : pool)
+    t.join();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - started)
+                       .count();
+
+  WorkerStats total;
+  for (const WorkerStats &s : stats) {
+    total.games += s.games;
+    total.steps += s.steps;
+    for (int c = 0; c < CAUSE_COUNT; ++c)
+      total.causes[c] += s.causes[c];
+  }
+  report(opt, scores, total, seconds, threads);
+  return 0;
+}
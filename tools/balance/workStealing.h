@@ -0,0 +1,78 @@
+#ifndef WORKSTEALING_H
+#define WORKSTEALING_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Hands out the items [0, count) to a fixed set of workers. Every worker
+// owns a range and takes items from its front; once it runs dry it steals
+// the back half of another worker's range. A range is packed into one
+// atomic word, so taking and stealing are single compare-and-swaps and no
+// lock is ever taken.
+class WorkStealingRanges {
+public:
+  WorkStealingRanges(uint32_t count, int workers) : slots(workers) {
+    for (int i = 0; i < workers; ++i) {
+      uint32_t begin = uint64_t(count) * i / workers;
+      uint32_t end = uint64_t(count) * (i + 1) / workers;
+      slots[i].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+  }
+
+  // Next item for worker, false once no worker has anything left
+  bool next(int worker, uint32_t &item) {
+    return take(worker, item) || steal(worker, item);
+  }
+
+private:
+  // own cache line each, workers hammer their own slot
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> range{0};
+  };
+
+  static uint64_t pack(uint32_t begin, uint32_t end) {
+    return (uint64_t(begin) << 32) | end;
+  }
+  static uint32_t begin(uint64_t r) { return uint32_t(r >> 32); }
+  static uint32_t end(uint64_t r) { return uint32_t(r); }
+
+  bool take(int worker, uint32_t &item) {
+    std::atomic<uint64_t> &range = slots[worker].range;
+    uint64_t r = range.load(std::memory_order_acquire);
+    while (begin(r) < end(r)) {
+      if (range.compare_exchange_weak(r, pack(begin(r) + 1, end(r)),
+                                      std::memory_order_acq_rel)) {
+        item = begin(r);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The thief's own slot is empty here, so nobody else modifies it until
+  // the stolen range is stored: other thieves only touch non-empty ranges,
+  // and ranges never repeat.
+  bool steal(int worker, uint32_t &item) {
+    const int n = int(slots.size());
+    for (int i = 1; i < n; ++i) {
+      std::atomic<uint64_t> &victim = slots[(worker + i) % n].range;
+      uint64_t r = victim.load(std::memory_order_acquire);
+      while (begin(r) < end(r)) {
+        uint32_t mid = begin(r) + (end(r) - begin(r)) / 2;
+        if (victim.compare_exchange_weak(r, pack(begin(r), mid),
+                                         std::memory_order_acq_rel)) {
+          item = mid;
+          slots[worker].range.store(pack(mid + 1, end(r)),
+                                    std::memory_order_release);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  std::vector<Slot> slots;
+};
+
+#endif // WORKSTEALING_H
@@ -0,0 +1,12 @@
+# Checks the SIMD batch simulation against GameState and measures its step
+# throughput. Build with e.g. QMAKE_CXXFLAGS+=-mavx2 to use wider vectors.
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= qt app_bundle
+
+TARGET = dinoBatch
+
+SOURCES += \
+    main.cpp
+
+include(../../gameCore/gameCore.pri)
@@ -0,0 +1,150 @@
+// Checks BatchSim against GameState step by step, then compares their
+// throughput in game steps per second.
+//
+// usage: dinoBatch [--games N] [--steps N] [--check-games N]
+//                  [--check-steps N]
+#include "batchSim.h"
+#include "gameState.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const float STEP = 1.f / 120.f;
+
+// Cheap per-game key mashing, the same for both simulations
+class Inputs {
+public:
+  explicit Inputs(int games) : state(games), inputs(games) {
+    for (int g = 0; g < games; ++g)
+      state[g] = 0x9e3779b9u * (g + 1);
+  }
+
+  const GameInput *next() {
+    for (size_t g = 0; g < state.size(); ++g) {
+      uint32_t &x = state[g];
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      GameInput &in = inputs[g];
+      in.jumpPressed = (x & 63) == 0;
+      in.jumpPhase = in.jumpPressed ? uint8_t(x >> 24) : 0;
+      in.duckPressed = (x >> 8 & 255) == 0;
+      in.duckReleased = (x >> 16 & 127) == 0;
+    }
+    return inputs.data();
+  }
+
+private:
+  std::vector<uint32_t> state;
+  std::vector<GameInput> inputs;
+};
+
+double seconds(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - since)
+      .count();
+}
+
+// Steps both side by side and compares every field after every step.
+// Finished games start over with a new seed.
+bool check(int games, int steps) {
+  BatchSim batch(games);
+  std::vector<GameState> scalar(games);
+  uint32_t nextSeed = 1;
+  for (int g = 0; g < games; ++g) {
+    batch.reset(g, nextSeed);
+    scalar[g].reset(nextSeed++);
+  }
+
+  Inputs inputs(games);
+  int mismatches = 0, overflows = 0, finished = 0;
+  for (int s = 0; s < steps; ++s) {
+    const GameInput *in = inputs.next();
+    batch.step(in, STEP);
+    for (int g = 0; g < games; ++g) {
+      unsigned events = scalar[g].step(in[g], STEP);
+      if (batch.overflowed(g)) {
+        ++overflows;
+      } else if (!batch.matches(g, scalar[g]) || batch.events(g) != events) {
+        if (++mismatches <= 10)
+          std::printf("mismatch: game %d step %d (score %d vs %d)\n", g, s,
+                      batch.score(g), scalar[g].score);
+      }
+      if (scalar[g].gameOver || batch.overflowed(g)) {
+        ++finished;
+        batch.reset(g, nextSeed);
+        scalar[g].reset(nextSeed++);
+      }
+    }
+  }
+
+  std::printf("check: %d games x %d steps, %d runs finished, %d mismatches, "
+              "%d overflowed\n",
+              games, steps, finished, mismatches, overflows);
+  return mismatches == 0;
+}
+
+void benchmark(int games, int steps) {
+  Inputs batchInputs(games);
+  BatchSim batch(games);
+  for (int g = 0; g < games; ++g)
+    batch.reset(g, g + 1);
+  auto started = std::chrono::steady_clock::now();
+  for (int s = 0; s < steps; ++s) {
+    const GameInput *in = batchInputs.next();
+    batch.step(in, STEP);
+    for (int g = 0; g < games; ++g) {
+      if (batch.gameOver(g))
+        batch.reset(g, g + 1 + s);
+    }
+  }
+  double batchRate = double(games) * steps / seconds(started);
+
+  Inputs scalarInputs(games);
+  std::vector<GameState> scalar(games);
+  for (int g = 0; g < games; ++g)
+    scalar[g].reset(g + 1);
+  started = std::chrono::steady_clock::now();
+  for (int s = 0; s < steps; ++s) {
+    const GameInput *in = scalarInputs.next();
+    for (int g = 0; g < games; ++g) {
+      scalar[g].step(in[g], STEP);
+      if (scalar[g].gameOver)
+        scalar[g].reset(g + 1 + s);
+    }
+  }
+  double scalarRate = double(games) * steps / seconds(started);
+
+  std::printf("batch (%s): %.3g steps/s\nscalar: %.3g steps/s\n"
+              "speedup: %.2fx\n",
+              BatchSim::isa(), batchRate, scalarRate, batchRate / scalarRate);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int games = 4096, steps = 2000, checkGames = 512, checkSteps = 20000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    int value = std::atoi(argv[i + 1]);
+    if (!std::strcmp(argv[i], "--games"))
+      games = value;
+    else if (!std::strcmp(argv[i], "--steps"))
+      steps = value;
+    else if (!std::strcmp(argv[i], "--check-games"))
+      checkGames = value;
+    else if (!std::strcmp(argv[i], "--check-steps"))
+      checkSteps = value;
+    else {
+      std::fprintf(stderr, "usage: dinoBatch [--games N] [--steps N] "
+                           "[--check-games N] [--check-steps N]\n");
+      return 1;
+    }
+  }
+
+  bool ok = check(checkGames, checkSteps);
+  benchmark(games, steps);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+# Measures the environment's throughput in env steps per second, with and
+# without rendered frames
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= qt app_bundle
+
+TARGET = dinoEnvBench
+
+INCLUDEPATH += ../../gameEnv
+
+SOURCES += \
+    main.cpp \
+    ../../gameEnv/dinoEnv.cpp
+
+HEADERS += \
+    ../../gameEnv/dinoEnv.h
+
+include(../../gameCore/gameCore.pri)
+
+LIBS += -lrt
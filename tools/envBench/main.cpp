@@ -0,0 +1,101 @@
+// Steps a batch of environments with random actions, resetting the ones
+// that are done, and reports env steps per second.
+//
+// usage: dinoEnvBench [--envs N] [--steps N] [--frame-scale N] [--shm NAME]
+#include "dinoEnv.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Options {
+  int envs = 256;
+  int steps = 20000;
+  int frameScale = 4;
+  const char *shm = nullptr;
+};
+
+// Returns env steps per second, or a negative value if the env could not
+// be created
+double run(const Options &opt, int frameScale) {
+  DinoEnv *env = dino_env_create(opt.envs, opt.shm, frameScale);
+  if (!env)
+    return -1.0;
+  dino_env_reset(env, 1);
+
+  // mostly standing, as a trained agent would be
+  std::vector<uint8_t> actions(opt.envs);
+  uint32_t x = 0x9e3779b9u;
+  uint32_t nextSeed = opt.envs + 1;
+  long episodes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int s = 0; s < opt.steps; ++s) {
+    for (uint8_t &a : actions) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      a = (x & 31) == 0 ? DINO_ACTION_JUMP
+                        : (x >> 8 & 63) == 0 ? DINO_ACTION_DUCK
+                                             : DINO_ACTION_NONE;
+    }
+    dino_env_step(env, actions.data());
+    const uint8_t *dones = dino_env_dones(env);
+    for (int e = 0; e < opt.envs; ++e) {
+      if (dones[e]) {
+        dino_env_reset_one(env, e, nextSeed++);
+        ++episodes;
+      }
+    }
+  }
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  const DinoEnvHeader *h = dino_env_header(env);
+  std::printf("  frames %s: %ld episodes, region %llu bytes",
+              frameScale ? "on " : "off", episodes,
+              (unsigned long long)h->size);
+  if (frameScale)
+    std::printf(", frame %ux%u", h->frame_width, h->frame_height);
+  std::printf("\n");
+  dino_env_destroy(env);
+  return double(opt.envs) * opt.steps / secs;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--envs") && i + 1 < argc)
+      opt.envs = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--steps") && i + 1 < argc)
+      opt.steps = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--frame-scale") && i + 1 < argc)
+      opt.frameScale = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--shm") && i + 1 < argc)
+      opt.shm = argv[++i];
+    else {
+      std::fprintf(stderr,
+                   "usage: %s [--envs N] [--steps N] [--frame-scale N] "
+                   "[--shm NAME]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::printf("%d envs, %d steps\n", opt.envs, opt.steps);
+  double plain = run(opt, 0);
+  double framed = opt.frameScale > 0 ? run(opt, opt.frameScale) : 0.0;
+  if (plain < 0 || framed < 0) {
+    std::fprintf(stderr, "could not create the environment\n");
+    return 1;
+  }
+  std::printf("env steps/s: %.0f without frames", plain);
+  if (opt.frameScale > 0)
+    std::printf(", %.0f with frames", framed);
+  std::printf("\n");
+  return 0;
+}
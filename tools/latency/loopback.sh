@@ -0,0 +1,47 @@
+#!/bin/sh
+# Input-to-frame latency without hardware, e.g. in CI: runs the game
+# offscreen with the fake GPIO backend and presses the up button through
+# its FIFO until the game has measured enough jumps.
+#
+# usage: tools/latency/loopback.sh <path to Dinosaur> [jumps]
+set -e
+GAME=${1:?usage: $0 <path to Dinosaur> [jumps]}
+JUMPS=${2:-50}
+
+DIR=$(mktemp -d)
+FIFO=$DIR/buttons
+mkfifo "$FIFO"
+PID=
+cleanup() {
+    [ -n "$PID" ] && kill "$PID" 2>/dev/null
+    rm -rf "$DIR"
+}
+trap cleanup EXIT
+# writing after the game quit fails instead of killing the script
+trap '' PIPE
+
+DINO_GPIO=fake:$FIFO "$GAME" --latency "$JUMPS" -platform offscreen &
+PID=$!
+exec 3>"$FIFO"
+sleep 1
+
+# a press and release per jump, far enough apart for the dino to land;
+# runs that end are restarted by the game. Gives up after 3x the presses.
+n=0
+while kill -0 "$PID" 2>/dev/null && [ $n -lt $((JUMPS * 3)) ]; do
+    echo "0 1" >&3 2>/dev/null || break
+    sleep 0.05
+    echo "0 0" >&3 2>/dev/null || break
+    sleep 0.75
+    n=$((n + 1))
+done
+exec 3>&-
+
+if kill -0 "$PID" 2>/dev/null; then
+    echo "latency: only part of $JUMPS jumps measured after $n presses" >&2
+    exit 1
+fi
+status=0
+wait "$PID" || status=$?
+PID=
+exit $status
@@ -0,0 +1,131 @@
+// A writer thread steps a game as fast as it can and publishes a snapshot
+// after every step, as the simulation thread does; the reader takes the
+// newest one in a loop, as frames do. Each snapshot carries a sequence
+// number and a hash of its contents, so a snapshot the reader sees half
+// written, or out of order, is counted.
+//
+// usage: dinoSnapshotStress [--seconds N]
+#include "renderSnapshot.h"
+#include "tripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+void mix(uint64_t &h, uint64_t v) {
+  h ^= v;
+  h *= 1099511628211ull;
+}
+
+void mix(uint64_t &h, float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  mix(h, uint64_t(bits));
+}
+
+void mix(uint64_t &h, const GameState::Obstacles &pool) {
+  mix(h, uint64_t(pool.size()));
+  for (int i = 0; i < pool.size(); ++i) {
+    GameRect r = pool[i];
+    mix(h, r.x);
+    mix(h, r.y);
+    mix(h, r.w);
+    mix(h, r.h);
+    mix(h, uint64_t(pool.type(i)));
+  }
+}
+
+// Of everything but jumpStepNs, which holds the hash
+uint64_t hashSnapshot(const RenderSnapshot &s) {
+  uint64_t h = 14695981039346656037ull;
+  mix(h, uint64_t(s.timeNs));
+  mix(h, s.dino.x);
+  mix(h, s.dino.y);
+  mix(h, s.prevDinoY);
+  mix(h, uint64_t(s.state));
+  mix(h, uint64_t(s.runFrame * 31 + s.duckFrame * 7 + s.birdFrame));
+  mix(h, s.cactus);
+  mix(h, s.birds);
+  mix(h, s.clouds);
+  mix(h, s.groundScroll);
+  mix(h, s.speed);
+  mix(h, uint64_t(s.score));
+  mix(h, uint64_t(s.isNight | s.started << 1 | s.gameOver << 2));
+  mix(h, uint64_t(s.jumps));
+  mix(h, uint64_t(s.points));
+  mix(h, uint64_t(s.jumpPressNs));
+  return h;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  double seconds = 5.0;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr, "usage: %s [--seconds N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  TripleBuffer<RenderSnapshot> buffer;
+  std::atomic<bool> done{false};
+  uint64_t published = 0;
+
+  std::thread writer([&]() {
+    GameState game;
+    game.reset(1u);
+    const float step = 1.f / 120.f;
+    int64_t seq = 0;
+    while (!done.load(std::memory_order_relaxed)) {
+      // jumps every half second, so runs last and obstacles pile up
+      GameInput input;
+      input.jumpPressed = seq % 60 == 0;
+      game.step(input, step);
+      if (game.gameOver)
+        game.reset(uint32_t(seq));
+
+      RenderSnapshot &s = buffer.back();
+      s.capture(game);
+      s.timeNs = ++seq;
+      s.jumps = uint32_t(seq);
+      s.jumpPressNs = seq * 3;
+      s.jumpStepNs = int64_t(hashSnapshot(s));
+      buffer.publish();
+    }
+    published = uint64_t(seq);
+  });
+
+  uint64_t reads = 0, updates = 0, torn = 0, backwards = 0;
+  int64_t lastSeq = 0;
+  auto end = std::chrono::steady_clock::now() +
+             std::chrono::duration<double>(seconds);
+  while (std::chrono::steady_clock::now() < end) {
+    if (buffer.update())
+      ++updates;
+    const RenderSnapshot &s = buffer.front();
+    ++reads;
+    if (s.timeNs == 0)
+      continue; // nothing published yet
+    if (int64_t(hashSnapshot(s)) != s.jumpStepNs)
+      ++torn;
+    if (s.timeNs < lastSeq)
+      ++backwards;
+    lastSeq = s.timeNs;
+  }
+  done = true;
+  writer.join();
+
+  std::printf("%llu snapshots published, %llu taken, %llu reads: "
+              "%llu torn, %llu out of order\n",
+              (unsigned long long)published, (unsigned long long)updates,
+              (unsigned long long)reads, (unsigned long long)torn,
+              (unsigned long long)backwards);
+  return torn || backwards ? 1 : 0;
+}
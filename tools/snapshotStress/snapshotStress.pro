@@ -0,0 +1,20 @@
+# Hammers the triple buffer that hands render snapshots from the simulation
+# thread to the GUI thread, checking that no snapshot is ever seen torn.
+# Build with CONFIG+=tsan to run it under ThreadSanitizer.
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= qt app_bundle
+
+TARGET = dinoSnapshotStress
+
+SOURCES += \
+    main.cpp
+
+include(../../gameCore/gameCore.pri)
+
+LIBS += -lpthread
+
+tsan {
+    QMAKE_CXXFLAGS += -fsanitize=thread -g
+    QMAKE_LFLAGS += -fsanitize=thread
+}
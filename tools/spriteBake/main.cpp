@@ -0,0 +1,127 @@
+// Bakes every sprite the game loads into one blob of pre-scaled,
+// premultiplied pixels (see spriteBlob.h for the layout).
+//
+// usage: spriteBake <images dir> <output file>
+#include "spriteBlob.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <cstring>
+
+using namespace SpriteBlobFormat;
+
+namespace {
+
+struct SpriteSpec {
+  QString name;
+  QSize box;
+};
+
+// Every loadSprite() call in the game. Keep in sync, a sprite missing here
+// is still decoded at runtime.
+QVector<SpriteSpec> manifest() {
+  QVector<SpriteSpec> specs;
+  // dinosaur
+  specs.push_back({"Cloud", QSize(60, 60)});
+  specs.push_back({"Ground", QSize(0, 20)});
+  specs.push_back({"Game_Over", QSize(200, 60)});
+  specs.push_back({"Back_Button", QSize(48, 48)});
+  specs.push_back({"Restart", QSize(48, 48)});
+  specs.push_back({"Bird1", QSize(42, 27)});
+  specs.push_back({"Bird2", QSize(42, 27)});
+  for (int i = 1; i <= 3; ++i) {
+    specs.push_back({QString("LargeCactus%1").arg(i), QSize(60, 35)});
+    specs.push_back({QString("SmallCactus%1").arg(i), QSize(60, 25)});
+  }
+
+  // skins (skinCache.cpp)
+  const char *skins[] = {"Dino", "Hat", "Santa", "Cowboy", "Pirate"};
+  for (const char *skin : skins) {
+    bool normal = QString(skin) == "Dino";
+    QSize size = normal ? QSize(36, 40) : QSize(38, 42);
+    QSize duckSize = normal ? QSize(72, 25) : QSize(72, 28);
+    const QString base = QString("%1_").arg(skin);
+    specs.push_back({base + "Start", size});
+    specs.push_back({base + "Jump", size});
+    specs.push_back({base + "Dead", size});
+    for (int i = 1; i <= 2; ++i) {
+      specs.push_back({base + QString("Run_%1").arg(i), size});
+      specs.push_back({base + QString("Duck_%1").arg(i), duckSize});
+    }
+
+    // menus (mainWindow.cpp)
+    specs.push_back({base + "Start", QSize(50, 50)});
+    specs.push_back({base + "Start", QSize(30, 30)});
+  }
+  specs.push_back({"Trophy", QSize(30, 30)});
+  return specs;
+}
+
+quint32 align16(quint32 v) { return (v + 15) & ~15u; }
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QTextStream err(stderr);
+
+  if (argc != 3) {
+    err << "usage: spriteBake <images dir> <output file>\n";
+    return 2;
+  }
+  const QString imageDir = QString::fromLocal8Bit(argv[1]);
+  const QString outPath = QString::fromLocal8Bit(argv[2]);
+
+  QVector<Entry> entries;
+  QVector<QImage> images;
+  for (const SpriteSpec &spec : manifest()) {
+    QImage src(QString("%1/%2.png").arg(imageDir, spec.name));
+    if (src.isNull()) {
+      err << "cannot read " << spec.name << ".png\n";
+      return 1;
+    }
+    QImage img = scaleSprite(src, spec.box);
+
+    Entry e;
+    std::memset(&e, 0, sizeof(e));
+    QByteArray key = spriteKey(spec.name, spec.box).toLatin1();
+    if (key.size() >= NAME_SIZE) {
+      err << "sprite key too long: " << key << "\n";
+      return 1;
+    }
+    std::memcpy(e.name, key.constData(), key.size());
+    e.width = img.width();
+    e.height = img.height();
+    e.bytesPerLine = img.bytesPerLine();
+    entries.push_back(e);
+    images.push_back(img);
+  }
+
+  quint32 offset = align16(sizeof(Header) + entries.size() * sizeof(Entry));
+  for (Entry &e : entries) {
+    e.offset = offset;
+    offset = align16(offset + e.bytesPerLine * e.height);
+  }
+
+  QFile out(outPath);
+  if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    err << "cannot write " << outPath << "\n";
+    return 1;
+  }
+
+  Header header = {MAGIC, VERSION, quint32(entries.size()), 0};
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(entries.constData()),
+            entries.size() * sizeof(Entry));
+  for (int i = 0; i < entries.size(); ++i) {
+    out.write(QByteArray(entries[i].offset - out.pos(), '\0'));
+    out.write(reinterpret_cast<const char *>(images[i].constBits()),
+              images[i].sizeInBytes());
+  }
+  out.close();
+
+  err << "baked " << entries.size() << " sprites into " << outPath << " ("
+      << out.size() / 1024 << " KiB)\n";
+  return 0;
+}
@@ -0,0 +1,15 @@
+# Host tool that bakes the game sprites into sprites.bin, see Dinosaur.pro
+QT       += core gui
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../spriteBlob.cpp
+
+HEADERS += \
+    ../../spriteBlob.h
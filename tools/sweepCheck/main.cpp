@@ -0,0 +1,90 @@
+// Steps a game with deliberately large dt values, with a cactus or a bird
+// just in front of the dino, and checks that each step reports EVENT_HIT.
+// Some cases end with the obstacle fully past the dino, which a test of the
+// end positions alone would miss; they fail if the obstacle does not get
+// past. Exits non-zero if any case fails.
+//
+// usage: dinoSweepCheck
+#include "gameState.h"
+#include <cstdio>
+
+namespace {
+
+enum Kind { CACTUS, BIRD };
+
+struct Case {
+  Kind kind;
+  float gap;   // from the dino's right edge to the obstacle
+  float speed; // of the ground; birds move birdSpeedFactor times faster
+  float dt;
+  bool hit;  // expected
+  bool past; // the obstacle ends the step fully past the dino
+};
+
+// A started run with one obstacle and no spawning, box collisions only
+GameState makeGame(const Case &c) {
+  GameState g;
+  g.reset();
+  g.started = true;
+  g.currentState = GameState::RUN;
+  g.spawnTimer = 1e9f;
+  g.speed = c.speed;
+
+  const GameConfig &cfg = g.config();
+  float x = g.dino.right() + c.gap;
+  if (c.kind == CACTUS) {
+    const int type = 1; // large, as wide as the dino
+    g.cactus.spawn(GameRect{x, float(cfg.groundY - cfg.cactusH[type]),
+                            float(cfg.cactusW[type]),
+                            float(cfg.cactusH[type])},
+                   type);
+  } else {
+    // at the height of the standing dino
+    g.birds.spawn(GameRect{x, g.dino.y + 10.f, float(cfg.birdW),
+                           float(cfg.birdH)});
+  }
+  return g;
+}
+
+GameRect obstacle(const GameState &g, Kind kind) {
+  return kind == CACTUS ? g.cactus[0] : g.birds[0];
+}
+
+} // namespace
+
+int main() {
+  const GameConfig cfg;
+  const Case cases[] = {
+      // a cactus 5px in front of the dino; at 0.5 s it ends up past it
+      {CACTUS, 5.f, cfg.baseSpeed, 0.1f, true, false},
+      {CACTUS, 5.f, cfg.baseSpeed, 0.25f, true, false},
+      {CACTUS, 5.f, cfg.baseSpeed, 0.5f, true, true},
+      // the fastest birds, at maxSpeed * birdSpeedFactor
+      {BIRD, 5.f, cfg.maxSpeed, 0.1f, true, false},
+      {BIRD, 5.f, cfg.maxSpeed, 0.25f, true, true},
+      {BIRD, 5.f, cfg.maxSpeed, 0.5f, true, true},
+      // too far away to be reached within the step
+      {CACTUS, 300.f, cfg.baseSpeed, 0.1f, false, false},
+      {BIRD, 300.f, cfg.maxSpeed, 0.1f, false, false},
+  };
+
+  int failed = 0;
+  for (const Case &c : cases) {
+    GameState g = makeGame(c);
+    unsigned events = g.step(GameInput(), c.dt);
+    bool hit = (events & EVENT_HIT) != 0;
+    GameRect o = obstacle(g, c.kind);
+    bool past = o.right() <= g.dino.x;
+
+    bool ok = hit == c.hit && (past || !c.past);
+    failed += !ok;
+    std::printf("%-6s gap %5.1f px  %5.0f px/s  dt %.2f s  %-4s %s%s\n",
+                c.kind == CACTUS ? "cactus" : "bird", c.gap,
+                c.kind == CACTUS ? c.speed : c.speed * cfg.birdSpeedFactor,
+                c.dt, hit ? "hit" : "miss", ok ? "ok" : "FAILED",
+                past ? " (ends past the dino)" : "");
+  }
+  std::printf("%d of %zu cases failed\n", failed,
+              sizeof(cases) / sizeof(cases[0]));
+  return failed ? 1 : 0;
+}
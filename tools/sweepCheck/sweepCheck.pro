@@ -0,0 +1,12 @@
+# Checks that collisions are swept over the whole step: obstacles that pass
+# through the dino within one large step must still hit it
+TEMPLATE = app
+CONFIG += c++17 console
+CONFIG -= qt app_bundle
+
+TARGET = dinoSweepCheck
+
+SOURCES += \
+    main.cpp
+
+include(../../gameCore/gameCore.pri)